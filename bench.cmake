@@ -0,0 +1,26 @@
+#
+# benchmarks
+#
+option(KIRAZ_BENCH "Build the bench_kiraz benchmarks" FALSE)
+
+if (KIRAZ_BENCH)
+    # prefer an installed google-benchmark, fetch a pinned release otherwise
+    find_package(benchmark QUIET)
+
+    if (NOT benchmark_FOUND)
+        include(FetchContent)
+        FetchContent_Declare(
+          googlebenchmark
+          URL https://github.com/google/benchmark/archive/refs/tags/v1.8.3.zip
+        )
+
+        set(BENCHMARK_ENABLE_TESTING OFF CACHE BOOL "" FORCE)
+        set(BENCHMARK_ENABLE_GTEST_TESTS OFF CACHE BOOL "" FORCE)
+        set(BENCHMARK_ENABLE_INSTALL OFF CACHE BOOL "" FORCE)
+        FetchContent_MakeAvailable(googlebenchmark)
+    endif()
+
+    # bench_kiraz
+    add_executable(bench_kiraz kiraz/bench/bench_kiraz.cc)
+    target_link_libraries(bench_kiraz kiraz benchmark::benchmark ${FLEX_LIBRARIES})
+endif()
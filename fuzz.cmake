@@ -0,0 +1,39 @@
+#
+# fuzzing
+#
+option(KIRAZ_FUZZ "Build fuzz_compile as a libFuzzer target, needs clang" FALSE)
+
+# fuzz_compile replays the seed corpus, with KIRAZ_FUZZ libFuzzer drives it instead
+add_executable(fuzz_compile kiraz/fuzz/fuzz_compile.cc)
+
+if (KIRAZ_FUZZ)
+    if (NOT IS_CC_CLANG)
+        message(FATAL_ERROR "KIRAZ_FUZZ needs clang for -fsanitize=fuzzer")
+    endif()
+
+    # coverage of the compiler guides the search along with the cost counters of the harness. The
+    # instrumented copy is fuzz_compile's own, kiraz and the targets linking it stay as they are.
+    get_target_property(KIRAZ_FUZZ_SOURCES kiraz_objects SOURCES)
+    add_library(kiraz_fuzz STATIC
+        ${KIRAZ_FUZZ_SOURCES}
+        kiraz/Prelude.h
+        kiraz/Prelude.cpp
+        ${PRELUDE_IO_H}
+    )
+    target_compile_options(kiraz_fuzz PRIVATE -fsanitize=fuzzer-no-link)
+    target_link_libraries(kiraz_fuzz PUBLIC Threads::Threads)
+
+    target_compile_options(fuzz_compile PRIVATE -fsanitize=fuzzer)
+    target_compile_definitions(fuzz_compile PRIVATE KIRAZ_LIBFUZZER)
+    target_link_libraries(fuzz_compile kiraz_fuzz ${FLEX_LIBRARIES} -fsanitize=fuzzer)
+else()
+    target_link_libraries(fuzz_compile kiraz ${FLEX_LIBRARIES})
+
+    # its budget is partly wall clock time, so it runs with the perf tests
+    if (KIRAZ_PERF_TESTS)
+        add_test(NAME fuzz_regression
+            COMMAND fuzz_compile ${CMAKE_CURRENT_SOURCE_DIR}/kiraz/fuzz/corpus
+        )
+        set_tests_properties(fuzz_regression PROPERTIES LABELS perf RUN_SERIAL TRUE)
+    endif()
+endif()
@@ -0,0 +1,101 @@
+
+#include "Arena.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SANITIZE_ADDRESS__)
+#define KIRAZ_ASAN 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define KIRAZ_ASAN 1
+#endif
+#endif
+
+#ifdef KIRAZ_ASAN
+#include <sanitizer/asan_interface.h>
+#endif
+
+namespace {
+
+/* Debug builds fill released blocks with this, a node used after its arena is gone shows it */
+constexpr int RELEASED_BYTE = 0xdd;
+
+/*
+ * A pooled block may still be reachable through a node that outlived its arena. ASan reports any
+ * access to it until the block is handed out again, debug builds at least make it recognizable.
+ */
+void release(std::byte *data) {
+#ifndef NDEBUG
+    std::memset(data, RELEASED_BYTE, Arena::DEFAULT_BLOCK_SIZE);
+#endif
+#ifdef KIRAZ_ASAN
+    ASAN_POISON_MEMORY_REGION(data, Arena::DEFAULT_BLOCK_SIZE);
+#endif
+}
+
+void reuse(std::byte *data) {
+#ifdef KIRAZ_ASAN
+    ASAN_UNPOISON_MEMORY_REGION(data, Arena::DEFAULT_BLOCK_SIZE);
+#endif
+}
+
+/* Default sized blocks released by the arenas of this thread */
+std::vector<std::unique_ptr<std::byte[]>> &get_pool() {
+    // unpoisoned before they are freed, ASan would report the delete otherwise
+    struct Pool : std::vector<std::unique_ptr<std::byte[]>> {
+        ~Pool() {
+            for (auto &block : *this) {
+                reuse(block.get());
+            }
+        }
+    };
+    thread_local Pool pool;
+    return pool;
+}
+
+} // namespace
+
+Arena::~Arena() {
+    // oversized blocks are rare and of any size, only default sized ones are worth keeping
+    auto &pool = get_pool();
+    for (auto &block : m_blocks) {
+        if (block.size == DEFAULT_BLOCK_SIZE
+                && (pool.size() + 1) * DEFAULT_BLOCK_SIZE <= MAX_POOLED_SIZE) {
+            release(block.data.get());
+            pool.push_back(std::move(block.data));
+        }
+    }
+}
+
+size_t Arena::get_num_pooled() {
+    return get_pool().size();
+}
+
+void *Arena::allocate_block(size_t size, size_t align) {
+    // oversized requests get a block of their own, so the current block stays in use
+    auto block_size = std::max(m_block_size, size + align);
+    auto &pool = get_pool();
+    std::unique_ptr<std::byte[]> data;
+    if (block_size == DEFAULT_BLOCK_SIZE && ! pool.empty()) {
+        data = std::move(pool.back());
+        pool.pop_back();
+        reuse(data.get());
+    }
+    else {
+        data.reset(new std::byte[block_size]);
+    }
+    m_blocks.push_back({std::move(data), block_size});
+    auto &block = m_blocks.back().data;
+    m_reserved += block_size;
+
+    auto begin = reinterpret_cast<uintptr_t>(block.get());
+    auto ptr = (begin + align - 1) & ~(uintptr_t(align) - 1);
+    if (block_size == m_block_size) {
+        m_head = ptr + size;
+        m_end = begin + block_size;
+    }
+
+    m_allocated += size;
+    return reinterpret_cast<void *>(ptr);
+}
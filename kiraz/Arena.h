@@ -0,0 +1,98 @@
+#ifndef KIRAZ_ARENA_H
+#define KIRAZ_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Arena: Bump allocator that hands out memory from large blocks and releases all of it at
+ *        once on destruction. Individual allocations are never freed. Blocks of the default size
+ *        are kept in a bounded per-thread pool on destruction, so the next Arena on the same
+ *        thread starts with memory that is already mapped in. Pooled blocks are poisoned under
+ *        ASan and filled with a pattern in debug builds.
+ */
+class Arena {
+public:
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+    /* Upper bound of the memory a thread keeps for later arenas */
+    static constexpr size_t MAX_POOLED_SIZE = 16 * 1024 * 1024;
+
+    explicit Arena(size_t block_size = DEFAULT_BLOCK_SIZE) : m_block_size(block_size) {}
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+    ~Arena();
+
+    void *allocate(size_t size, size_t align) {
+        auto ptr = (m_head + align - 1) & ~(uintptr_t(align) - 1);
+        if (ptr + size > m_end || m_head == 0) {
+            return allocate_block(size, align);
+        }
+
+        m_head = ptr + size;
+        m_allocated += size;
+        return reinterpret_cast<void *>(ptr);
+    }
+
+    /**
+     * @brief get_allocated: Returns the number of bytes handed out so far.
+     */
+    auto get_allocated() const { return m_allocated; }
+
+    /**
+     * @brief get_reserved: Returns the number of bytes obtained from the system so far.
+     */
+    auto get_reserved() const { return m_reserved; }
+
+    /**
+     * @brief get_num_pooled: Returns the number of blocks pooled on the calling thread.
+     */
+    static size_t get_num_pooled();
+
+private:
+    void *allocate_block(size_t size, size_t align);
+
+    struct Block {
+        std::unique_ptr<std::byte[]> data;
+        size_t size;
+    };
+
+    std::vector<Block> m_blocks;
+    size_t m_block_size;
+    uintptr_t m_head = 0;
+    uintptr_t m_end = 0;
+    size_t m_allocated = 0;
+    size_t m_reserved = 0;
+};
+
+/**
+ * @brief ArenaAllocator: Standard allocator adaptor over an Arena, e.g. for std::allocate_shared.
+ *        Deallocation is a no-op, memory is reclaimed when the Arena goes away.
+ */
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(Arena &arena) : m_arena(&arena) {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &other) : m_arena(other.get_arena()) {}
+
+    T *allocate(size_t n) { return static_cast<T *>(m_arena->allocate(n * sizeof(T), alignof(T))); }
+    void deallocate(T *, size_t) {}
+
+    Arena *get_arena() const { return m_arena; }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U> &other) const {
+        return m_arena == other.get_arena();
+    }
+
+private:
+    Arena *m_arena;
+};
+
+#endif // KIRAZ_ARENA_H
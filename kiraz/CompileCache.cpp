@@ -0,0 +1,228 @@
+
+#include "CompileCache.h"
+
+#include <algorithm>
+#include <filesystem>
+
+#include <fmt/format.h>
+
+#include <kiraz/FileWriter.h>
+#include <kiraz/MappedFile.h>
+#include <resource/build_id.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+/* Bump when the entry layout changes */
+constexpr char MAGIC[4] = {'K', 'Z', 'C', 1};
+constexpr std::string_view EXTENSION = ".kzc";
+
+std::string get_build_id() {
+    // a rebuilt compiler may generate different code for the same source, so the build is part
+    // of the key. The running binary is the best witness, the hash of the sources it was built
+    // from stands in elsewhere.
+    ModuleInterface::Stamp stamp;
+    if (ModuleInterface::Stamp::of("/proc/self/exe", stamp)) {
+        return fmt::format("{}:{}", stamp.size, stamp.mtime);
+    }
+    return KIRAZ_BUILD_ID;
+}
+
+uint64_t hash(uint64_t state, std::string_view text) {
+    // FNV-1a, entries hold their full key so a collision costs a miss and nothing more
+    for (auto c : text) {
+        state = (state ^ uint8_t(c)) * 0x100000001b3;
+    }
+    return (state ^ 0xff) * 0x100000001b3;
+}
+
+void put_u64(std::string &out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(char(value >> (8 * i)));
+    }
+}
+
+void put_text(std::string &out, std::string_view text) {
+    put_u64(out, text.size());
+    out.append(text);
+}
+
+/* Reads an entry front to back, every read fails once the data runs out */
+struct EntryReader {
+    std::string_view data;
+    bool ok = true;
+
+    uint64_t get_u64() {
+        if (data.size() < 8) {
+            ok = false;
+            return 0;
+        }
+        uint64_t retval = 0;
+        for (int i = 0; i < 8; ++i) {
+            retval |= uint64_t(uint8_t(data[i])) << (8 * i);
+        }
+        data.remove_prefix(8);
+        return retval;
+    }
+
+    std::string_view get_text() {
+        auto size = get_u64();
+        if (! ok || size > data.size()) {
+            ok = false;
+            return {};
+        }
+        auto retval = data.substr(0, size);
+        data.remove_prefix(size);
+        return retval;
+    }
+};
+
+} // namespace
+
+CompileCache::CompileCache(std::string dir, uint64_t max_size)
+        : m_dir(std::move(dir)), m_max_size(max_size), m_build_id(get_build_id()) {
+    std::error_code ec;
+    fs::create_directories(m_dir, ec);
+}
+
+std::string CompileCache::get_entry_name(std::string_view options, std::string_view source) const {
+    auto key = hash(hash(hash(0xcbf29ce484222325, m_build_id), options), source);
+    return (fs::path(m_dir) / fmt::format("{:016x}{}", key, EXTENSION)).string();
+}
+
+bool CompileCache::lookup(std::string_view options, std::string_view source,
+        std::string &output) {
+    auto entry_name = get_entry_name(options, source);
+
+    auto is_hit = [&] {
+        MappedFile file;
+        if (! file.open(entry_name)) {
+            return false;
+        }
+
+        EntryReader entry{{file.data(), file.size()}};
+        if (! entry.data.starts_with(std::string_view(MAGIC, sizeof(MAGIC)))) {
+            return false;
+        }
+        entry.data.remove_prefix(sizeof(MAGIC));
+        if (entry.get_text() != m_build_id || entry.get_text() != options
+                || entry.get_text() != source) {
+            return false;
+        }
+
+        auto num_deps = entry.get_u64();
+        for (uint64_t i = 0; entry.ok && i < num_deps; ++i) {
+            std::string file_name(entry.get_text());
+            ModuleInterface::Stamp stamp;
+            stamp.size = entry.get_u64();
+            stamp.mtime = entry.get_u64();
+
+            ModuleInterface::Stamp current;
+            if (! ModuleInterface::Stamp::of(file_name, current) || ! (current == stamp)) {
+                return false;
+            }
+        }
+
+        auto text = entry.get_text();
+        if (! entry.ok) {
+            return false;
+        }
+        output.assign(text);
+        return true;
+    };
+
+    if (! is_hit()) {
+        ++m_misses;
+        return false;
+    }
+
+    // the modification time orders the entries for eviction
+    std::error_code ec;
+    fs::last_write_time(entry_name, fs::file_time_type::clock::now(), ec);
+    ++m_hits;
+    return true;
+}
+
+void CompileCache::store(std::string_view options, std::string_view source,
+        const std::vector<Dependency> &dependencies, std::string_view output) {
+    std::string entry(MAGIC, sizeof(MAGIC));
+    put_text(entry, m_build_id);
+    put_text(entry, options);
+    put_text(entry, source);
+    put_u64(entry, dependencies.size());
+    for (const auto &dep : dependencies) {
+        put_text(entry, dep.file_name);
+        put_u64(entry, dep.stamp.size);
+        put_u64(entry, dep.stamp.mtime);
+    }
+    put_text(entry, output);
+
+    // a replaced entry no longer takes up space, only the difference counts
+    auto entry_name = get_entry_name(options, source);
+    std::error_code ec;
+    auto replaced_size = fs::file_size(entry_name, ec);
+    if (ec) {
+        replaced_size = 0;
+    }
+
+    if (! FileWriter::replace(entry_name, entry)) {
+        return;
+    }
+    ++m_stores;
+
+    std::lock_guard lock(m_evict_mutex);
+    m_dir_size -= std::min(m_dir_size, replaced_size);
+    m_dir_size += entry.size();
+    if (! m_dir_size_known || m_dir_size > m_max_size) {
+        evict();
+    }
+}
+
+void CompileCache::evict() {
+    struct Entry {
+        fs::path path;
+        uint64_t size;
+        fs::file_time_type mtime;
+    };
+
+    // other processes may share the directory, so it is the authority on what is there
+    std::vector<Entry> entries;
+    uint64_t total = 0;
+    std::error_code ec;
+    for (const auto &item : fs::directory_iterator(m_dir, ec)) {
+        if (item.path().extension() != EXTENSION) {
+            continue;
+        }
+        std::error_code item_ec;
+        auto size = item.file_size(item_ec);
+        auto mtime = item.last_write_time(item_ec);
+        if (! item_ec) {
+            entries.push_back({item.path(), size, mtime});
+            total += size;
+        }
+    }
+
+    m_dir_size = total;
+    m_dir_size_known = true;
+    if (total <= m_max_size) {
+        return;
+    }
+
+    // trim below the limit, so the next few stores do not have to scan again
+    std::sort(entries.begin(), entries.end(),
+            [](const Entry &a, const Entry &b) { return a.mtime < b.mtime; });
+    for (const auto &entry : entries) {
+        if (m_dir_size <= m_max_size / 4 * 3) {
+            break;
+        }
+        if (fs::remove(entry.path, ec)) {
+            m_dir_size -= entry.size;
+            ++m_evictions;
+        }
+    }
+}
+
+CompileCache::Counters CompileCache::get_counters() const {
+    return {m_hits, m_misses, m_stores, m_evictions};
+}
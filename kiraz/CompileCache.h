@@ -0,0 +1,76 @@
+#ifndef KIRAZ_COMPILECACHE_H
+#define KIRAZ_COMPILECACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <kiraz/ModuleInterface.h>
+
+/**
+ * @brief CompileCache: On-disk store of compilation results, one file per entry named after a hash
+ *        of the compiler build, the options and the source. Entries also hold the full key and
+ *        the stamps of the imported modules, a hit requires all of them to match. The least
+ *        recently used entries are removed once the directory outgrows its size limit.
+ *        One instance may be shared by the compilers of several threads.
+ */
+class CompileCache {
+public:
+    static constexpr uint64_t DEFAULT_MAX_SIZE = uint64_t(256) << 20;
+
+    /* A file the output depends on besides the source, ie. an imported module */
+    struct Dependency {
+        std::string file_name;
+        ModuleInterface::Stamp stamp;
+    };
+
+    struct Counters {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t stores = 0;
+        size_t evictions = 0;
+    };
+
+    explicit CompileCache(std::string dir, uint64_t max_size = DEFAULT_MAX_SIZE);
+
+    /**
+     * @brief lookup: Fetches the output stored for the given options and source.
+     * @return false if there is none or a file it depended on has changed since
+     */
+    bool lookup(std::string_view options, std::string_view source, std::string &output);
+
+    /**
+     * @brief store: Saves the output of a successful compilation. Failures to write are ignored,
+     *        the next lookup simply misses.
+     */
+    void store(std::string_view options, std::string_view source,
+            const std::vector<Dependency> &dependencies, std::string_view output);
+
+    Counters get_counters() const;
+    const auto &get_dir() const { return m_dir; }
+
+private:
+    std::string get_entry_name(std::string_view options, std::string_view source) const;
+    void evict();
+
+    const std::string m_dir;
+    const uint64_t m_max_size;
+
+    /* Identifies the compiler build, see tools/build_id.cmake. Outputs of other builds are never
+     * reused */
+    const std::string m_build_id;
+
+    std::mutex m_evict_mutex;
+    uint64_t m_dir_size = 0;
+    bool m_dir_size_known = false;
+
+    std::atomic<size_t> m_hits = 0;
+    std::atomic<size_t> m_misses = 0;
+    std::atomic<size_t> m_stores = 0;
+    std::atomic<size_t> m_evictions = 0;
+};
+
+#endif // KIRAZ_COMPILECACHE_H
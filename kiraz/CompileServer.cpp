@@ -0,0 +1,249 @@
+#include "CompileServer.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <fmt/format.h>
+
+#include <kiraz/CompileCache.h>
+#include <kiraz/Compiler.h>
+#include <kiraz/Trace.h>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#else
+#include <io.h>
+#define read _read
+#define write _write
+#endif
+
+namespace {
+
+/* Returns the number of bytes read, less than size only at the end of the input */
+size_t read_full(int fd, char *data, size_t size) {
+    size_t done = 0;
+    while (done < size) {
+        auto ret = read(fd, data + done, size - done);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            break;
+        }
+        done += ret;
+    }
+    return done;
+}
+
+bool write_full(int fd, std::string_view data) {
+    while (! data.empty()) {
+        auto ret = write(fd, data.data(), data.size());
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            return false;
+        }
+        data.remove_prefix(ret);
+    }
+    return true;
+}
+
+uint32_t get_u32(const char *data) {
+    uint32_t retval = 0;
+    for (int i = 0; i < 4; ++i) {
+        retval |= uint32_t(uint8_t(data[i])) << (8 * i);
+    }
+    return retval;
+}
+
+void put_u32(std::string &out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(char(value >> (8 * i)));
+    }
+}
+
+} // namespace
+
+CompileServer::CompileServer(size_t num_workers, CompileCache *cache)
+        : m_cache(cache), m_pool(num_workers),
+          m_max_in_flight(2 * std::max<size_t>(num_workers, 1)) {}
+
+std::string CompileServer::encode_frame(uint32_t id, Kind kind, std::string_view payload) {
+    std::string retval;
+    retval.reserve(HEADER_SIZE + payload.size());
+    put_u32(retval, payload.size());
+    put_u32(retval, id);
+    retval.push_back(char(kind));
+    retval.append(payload);
+    return retval;
+}
+
+void CompileServer::compile(uint32_t id, Kind kind, const std::string &source,
+        std::string &response) {
+    Trace::Span span("request");
+    Compiler compiler;
+    compiler.set_cache(m_cache);
+    if (kind == COMPILE_WASM) {
+        compiler.set_target(Compiler::Target::Wasm);
+    }
+
+    if (auto status = compiler.compile_string(source); status != 0) {
+        auto error = compiler.get_error();
+        if (error.empty()) {
+            error = FF("Compilation failed with status {}", status);
+        }
+        response = encode_frame(id, DIAGNOSTICS, error);
+    }
+    else if (kind == COMPILE_WASM) {
+        const auto &binary = compiler.get_wasm_binary();
+        response = encode_frame(id, OUTPUT_WASM,
+                {reinterpret_cast<const char *>(binary.data()), binary.size()});
+    }
+    else {
+        response = encode_frame(id, OUTPUT_WAT, compiler.get_wasm_ctx().body().str());
+    }
+}
+
+bool CompileServer::serve(int in_fd, int out_fd) {
+    // responses of one connection share the output, the jobs of all connections share the pool
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t pending = 0;
+    bool ok = true;
+
+    auto respond = [&](std::string_view response) {
+        std::lock_guard lock(mutex);
+        ok = write_full(out_fd, response) && ok;
+    };
+
+    for (;;) {
+        char header[HEADER_SIZE];
+        auto num_read = read_full(in_fd, header, HEADER_SIZE);
+        if (num_read < HEADER_SIZE) {
+            std::lock_guard lock(mutex);
+            ok = num_read == 0 && ok;
+            break;
+        }
+
+        auto size = get_u32(header);
+        auto id = get_u32(header + 4);
+        auto kind = Kind(header[8]);
+        if (size > MAX_REQUEST_SIZE) {
+            respond(encode_frame(id, DIAGNOSTICS,
+                    FF("Error: Request of {} bytes exceeds the limit of {}", size,
+                            MAX_REQUEST_SIZE)));
+            std::lock_guard lock(mutex);
+            ok = false;
+            break;
+        }
+
+        std::string source(size, '\0');
+        if (read_full(in_fd, source.data(), size) < size) {
+            std::lock_guard lock(mutex);
+            ok = false;
+            break;
+        }
+
+        if (kind != COMPILE_WAT && kind != COMPILE_WASM) {
+            respond(encode_frame(id, DIAGNOSTICS, FF("Error: Unknown request kind {}", int(kind))));
+            continue;
+        }
+
+        // stop reading while the workers are busy, so a fast client can not queue up memory
+        {
+            std::unique_lock lock(m_mutex);
+            m_cv.wait(lock, [this] { return m_in_flight < m_max_in_flight; });
+            ++m_in_flight;
+        }
+        {
+            std::lock_guard lock(mutex);
+            ++pending;
+        }
+
+        m_pool.submit([this, &mutex, &cv, &pending, &respond, id, kind,
+                              source = std::move(source)] {
+            std::string response;
+            compile(id, kind, source, response);
+            respond(response);
+
+            {
+                std::lock_guard lock(m_mutex);
+                --m_in_flight;
+            }
+            m_cv.notify_one();
+
+            std::lock_guard lock(mutex);
+            --pending;
+            cv.notify_all();
+        });
+    }
+
+    std::unique_lock lock(mutex);
+    cv.wait(lock, [&pending] { return pending == 0; });
+    return ok;
+}
+
+bool CompileServer::listen(const std::string &socket_path) {
+#ifndef _WIN32
+    sockaddr_un addr{};
+    if (socket_path.size() >= sizeof(addr.sun_path)) {
+        errno = ENAMETOOLONG;
+        return false;
+    }
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, socket_path.data(), socket_path.size());
+
+    auto fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return false;
+    }
+
+    // a socket left behind by an earlier server would make bind fail
+    unlink(socket_path.data());
+    if (bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0
+            || ::listen(fd, SOMAXCONN) != 0) {
+        auto err = errno;
+        close(fd);
+        errno = err;
+        return false;
+    }
+
+    for (;;) {
+        // the thread of every connection holds on to a stack and its arena blocks
+        {
+            std::unique_lock lock(m_mutex);
+            m_connections_cv.wait(lock, [this] { return m_num_connections < MAX_CONNECTIONS; });
+        }
+
+        auto conn = accept(fd, nullptr, nullptr);
+        if (conn < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            auto err = errno;
+            close(fd);
+            errno = err;
+            return false;
+        }
+
+        {
+            std::lock_guard lock(m_mutex);
+            ++m_num_connections;
+        }
+        std::thread([this, conn] {
+            serve(conn, conn);
+            close(conn);
+
+            std::lock_guard lock(m_mutex);
+            --m_num_connections;
+            m_connections_cv.notify_one();
+        }).detach();
+    }
+#else
+    errno = ENOSYS;
+    return false;
+#endif
+}
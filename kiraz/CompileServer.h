@@ -0,0 +1,89 @@
+#ifndef KIRAZ_COMPILESERVER_H
+#define KIRAZ_COMPILESERVER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#include <kiraz/JobPool.h>
+
+class CompileCache;
+
+/**
+ * @brief CompileServer: Answers compile requests read from a file descriptor, so a long running
+ *        process can serve many compilations without paying the startup cost for each. Requests
+ *        are compiled concurrently on a pool of workers, each by a fresh Compiler whose memory is
+ *        released once the response is written. Arena blocks stay with the worker threads.
+ *
+ *        Requests and responses are framed the same way, all integers little endian:
+ *          u32 size                     size of the payload
+ *          u32 id                       chosen by the client, echoed in the response
+ *          u8 kind                      see Kind
+ *          size bytes                   payload
+ *
+ *        Responses may arrive in a different order than the requests.
+ */
+class CompileServer {
+public:
+    enum Kind : uint8_t {
+        /* requests, the payload is the source */
+        COMPILE_WAT = 't',
+        COMPILE_WASM = 'w',
+
+        /* responses */
+        OUTPUT_WAT = 'T',
+        OUTPUT_WASM = 'W',
+        DIAGNOSTICS = 'E',
+    };
+
+    static constexpr size_t HEADER_SIZE = 4 + 4 + 1;
+
+    /* Larger requests are answered with diagnostics and end the connection */
+    static constexpr uint32_t MAX_REQUEST_SIZE = 64 * 1024 * 1024;
+
+    /* Further clients wait in the listen backlog until a connection closes */
+    static constexpr size_t MAX_CONNECTIONS = 64;
+
+    explicit CompileServer(size_t num_workers = std::thread::hardware_concurrency(),
+            CompileCache *cache = nullptr);
+
+    /**
+     * @brief serve: Answers the requests read from in_fd on out_fd until in_fd reaches the end.
+     *        Returns once every response has been written.
+     * @return false if the input ended in the middle of a request or a response could not be
+     *         written
+     */
+    bool serve(int in_fd, int out_fd);
+
+    /**
+     * @brief listen: Binds a Unix domain socket at the given path and serves every connection on
+     *        its own thread, up to MAX_CONNECTIONS at a time, until the process is terminated.
+     * @return false with errno set if the socket could not be set up
+     */
+    bool listen(const std::string &socket_path);
+
+    /**
+     * @brief encode_frame: Returns the given frame in wire format, for clients.
+     */
+    static std::string encode_frame(uint32_t id, Kind kind, std::string_view payload);
+
+private:
+    void compile(uint32_t id, Kind kind, const std::string &source, std::string &response);
+
+    CompileCache *m_cache;
+    JobPool m_pool;
+
+    /* Requests read but not answered yet, bounds the memory held by queued sources */
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    size_t m_in_flight = 0;
+    const size_t m_max_in_flight;
+
+    /* Connections being served by listen() */
+    std::condition_variable m_connections_cv;
+    size_t m_num_connections = 0;
+};
+
+#endif // KIRAZ_COMPILESERVER_H
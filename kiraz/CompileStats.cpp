@@ -0,0 +1,197 @@
+#include "CompileStats.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include <fmt/format.h>
+
+#include <kiraz/Arena.h>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+uint64_t get_peak_rss() {
+#ifndef _WIN32
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#ifdef __APPLE__
+    return usage.ru_maxrss;
+#else
+    return uint64_t(usage.ru_maxrss) * 1024;
+#endif
+#else
+    return 0;
+#endif
+}
+
+/* Current resident set size, the peak where the platform offers nothing better */
+uint64_t get_rss() {
+#ifdef __linux__
+    // kept open, detailed mode samples it on every phase switch
+    static int fd = open("/proc/self/statm", O_RDONLY | O_CLOEXEC);
+    static uint64_t page_size = sysconf(_SC_PAGESIZE);
+
+    char buf[128];
+    auto len = fd < 0 ? -1 : pread(fd, buf, sizeof(buf) - 1, 0);
+    if (len <= 0) {
+        return 0;
+    }
+    buf[len] = '\0';
+
+    unsigned long long size, resident;
+    if (sscanf(buf, "%llu %llu", &size, &resident) != 2) {
+        return 0;
+    }
+    return resident * page_size;
+#else
+    return get_peak_rss();
+#endif
+}
+
+double to_ms(CompileStats::Clock::duration elapsed) {
+    return std::chrono::duration<double, std::milli>(elapsed).count();
+}
+
+} // namespace
+
+const char *CompileStats::get_name(Phase phase) {
+    switch (phase) {
+    case Phase::None:
+        return "none";
+    case Phase::Read:
+        return "read";
+    case Phase::Lex:
+        return "lex";
+    case Phase::Parse:
+        return "parse";
+    case Phase::Prelude:
+        return "prelude";
+    case Phase::SymtabForward:
+        return "symtab_forward";
+    case Phase::SymtabOrdered:
+        return "symtab_ordered";
+    case Phase::Check:
+        return "check";
+    case Phase::Lower:
+        return "lower";
+    case Phase::Optimize:
+        return "optimize";
+    case Phase::Emit:
+        return "emit";
+    case Phase::Count:
+        break;
+    }
+    return "?";
+}
+
+void CompileStats::set_detailed(bool detailed) {
+    m_detailed = detailed;
+    m_rss_mark = detailed ? get_rss() : 0;
+}
+
+void CompileStats::account(Clock::time_point now) {
+    auto &current = m_phases[size_t(m_current)];
+    current.elapsed += now - m_since;
+    m_since = now;
+
+    if (m_arena) {
+        auto allocated = m_arena->get_allocated();
+        current.arena_bytes += allocated - m_arena_mark;
+        m_arena_mark = allocated;
+    }
+
+    // memory released meanwhile lowers the mark, so only what the phase itself grew counts
+    if (m_detailed) {
+        auto rss = get_rss();
+        if (rss > m_rss_mark) {
+            current.rss_growth += rss - m_rss_mark;
+        }
+        m_rss_mark = rss;
+    }
+}
+
+CompileStats::Phase CompileStats::enter(Phase phase, bool new_run) {
+    account(Clock::now());
+    auto retval = m_current;
+    m_current = phase;
+    if (new_run) {
+        ++m_phases[size_t(phase)].num_runs;
+    }
+    return retval;
+}
+
+void CompileStats::leave(Phase prev) {
+    if (m_detailed) {
+        auto &current = m_phases[size_t(m_current)];
+        current.peak_rss = std::max(current.peak_rss, get_peak_rss());
+    }
+    enter(prev, false);
+}
+
+void CompileStats::merge(const CompileStats &other) {
+    for (size_t i = 0; i < m_phases.size(); ++i) {
+        auto &phase = m_phases[i];
+        const auto &other_phase = other.m_phases[i];
+        phase.elapsed += other_phase.elapsed;
+        phase.num_runs += other_phase.num_runs;
+        phase.arena_bytes += other_phase.arena_bytes;
+        phase.peak_rss = std::max(phase.peak_rss, other_phase.peak_rss);
+        phase.rss_growth += other_phase.rss_growth;
+    }
+
+    num_compilations += other.num_compilations;
+    num_tokens += other.num_tokens;
+    num_nodes += other.num_nodes;
+    num_scopes += other.num_scopes;
+    num_lookups += other.num_lookups;
+    num_bytes_emitted += other.num_bytes_emitted;
+}
+
+std::string CompileStats::to_table() const {
+    std::string retval = fmt::format("{:<16}{:>12}{:>10}{:>14}{:>16}{:>18}\n", "phase",
+            "time (ms)", "runs", "arena (KiB)", "peak rss (KiB)", "rss growth (KiB)");
+
+    Clock::duration total{};
+    uint64_t total_arena = 0;
+    for (size_t i = size_t(Phase::None) + 1; i < m_phases.size(); ++i) {
+        const auto &phase = m_phases[i];
+        retval += fmt::format("{:<16}{:>12.3f}{:>10}{:>14}{:>16}{:>18}\n", get_name(Phase(i)),
+                to_ms(phase.elapsed), phase.num_runs, phase.arena_bytes / 1024,
+                phase.peak_rss ? fmt::format("{}", phase.peak_rss / 1024) : "-",
+                m_detailed ? fmt::format("{}", phase.rss_growth / 1024) : "-");
+        total += phase.elapsed;
+        total_arena += phase.arena_bytes;
+    }
+    retval += fmt::format("{:<16}{:>12.3f}{:>10}{:>14}\n", "total", to_ms(total), "",
+            total_arena / 1024);
+
+    retval += fmt::format("{} compilations, {} tokens, {} nodes, {} scopes, {} lookups, "
+                          "{} bytes emitted\n",
+            num_compilations, num_tokens, num_nodes, num_scopes, num_lookups, num_bytes_emitted);
+    return retval;
+}
+
+std::string CompileStats::to_json() const {
+    std::string retval = "{\"phases\":{";
+    for (size_t i = size_t(Phase::None) + 1; i < m_phases.size(); ++i) {
+        const auto &phase = m_phases[i];
+        retval += fmt::format("{}\"{}\":{{\"ms\":{:.3f},\"runs\":{},\"arena_bytes\":{},"
+                              "\"peak_rss_bytes\":{},\"rss_growth_bytes\":{}}}",
+                i > size_t(Phase::None) + 1 ? "," : "", get_name(Phase(i)), to_ms(phase.elapsed),
+                phase.num_runs, phase.arena_bytes, phase.peak_rss, phase.rss_growth);
+    }
+    retval += fmt::format("}},\"compilations\":{},\"tokens\":{},\"nodes\":{},\"scopes\":{},"
+                          "\"lookups\":{},\"bytes_emitted\":{}}}",
+            num_compilations, num_tokens, num_nodes, num_scopes, num_lookups, num_bytes_emitted);
+    return retval;
+}
@@ -0,0 +1,128 @@
+#ifndef KIRAZ_COMPILESTATS_H
+#define KIRAZ_COMPILESTATS_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include <kiraz/Trace.h>
+
+class Arena;
+
+/**
+ * @brief CompileStats: Time, arena allocations and peak memory spent in each phase of the
+ *        compilations of one Compiler, along with counts of the work done. Time is attributed
+ *        exclusively: a phase entered from another one, eg. parsing an imported module while
+ *        building the symbol table, pauses the outer phase until it is left again.
+ *
+ *        Switching phases costs a clock read, so the coarse phases are always measured. Timing
+ *        every token and sampling the resident set size are left to detailed mode.
+ */
+class CompileStats {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum class Phase {
+        None,
+        Read,
+        Lex,
+        Parse,
+        Prelude,
+        SymtabForward,
+        SymtabOrdered,
+        Check,
+        Lower,
+        Optimize,
+        Emit,
+        Count,
+    };
+
+    struct PhaseStats {
+        Clock::duration elapsed{};
+        size_t num_runs = 0;
+
+        /* Bytes handed out by the arena while the phase ran */
+        uint64_t arena_bytes = 0;
+
+        /* Peak resident set size of the process when the phase was last left, detailed mode */
+        uint64_t peak_rss = 0;
+
+        /* Bytes the resident set size grew by while the phase ran, detailed mode */
+        uint64_t rss_growth = 0;
+    };
+
+    /**
+     * @brief Scope: Enters a phase for the lifetime of the object, returning to the previous one
+     *        afterwards. The phase also shows up as a span when tracing.
+     */
+    class Scope {
+    public:
+        Scope(CompileStats &stats, Phase phase)
+                : m_span(get_name(phase)), m_stats(stats), m_prev(stats.enter(phase)) {}
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+        ~Scope() { m_stats.leave(m_prev); }
+
+    private:
+        Trace::Span m_span;
+        CompileStats &m_stats;
+        Phase m_prev;
+    };
+
+    static const char *get_name(Phase phase);
+
+    void set_arena(const Arena *arena) { m_arena = arena; }
+    void set_detailed(bool detailed);
+    bool is_detailed() const { return m_detailed; }
+
+    /**
+     * @brief enter: Makes the given phase the current one.
+     * @param new_run: false when returning to a phase that was interrupted
+     * @return The phase that was current before
+     */
+    Phase enter(Phase phase, bool new_run = true);
+
+    /**
+     * @brief leave: Returns to the given phase, sampling the memory use in detailed mode.
+     */
+    void leave(Phase prev);
+
+    const PhaseStats &get(Phase phase) const { return m_phases[size_t(phase)]; }
+    Phase get_current() const { return m_current; }
+
+    /**
+     * @brief merge: Adds the figures of another instance, eg. of a compiler on another thread.
+     */
+    void merge(const CompileStats &other);
+
+    /**
+     * @brief to_table: Formats the figures as a table for humans, one phase per row.
+     */
+    std::string to_table() const;
+
+    /**
+     * @brief to_json: Formats the figures as a single JSON object.
+     */
+    std::string to_json() const;
+
+    size_t num_compilations = 0;
+    size_t num_tokens = 0;
+    size_t num_nodes = 0;
+    size_t num_scopes = 0;
+    size_t num_lookups = 0;
+    size_t num_bytes_emitted = 0;
+
+private:
+    void account(Clock::time_point now);
+
+    std::array<PhaseStats, size_t(Phase::Count)> m_phases;
+    Phase m_current = Phase::None;
+    Clock::time_point m_since = Clock::now();
+    uint64_t m_arena_mark = 0;
+    uint64_t m_rss_mark = 0;
+    const Arena *m_arena = nullptr;
+    bool m_detailed = false;
+};
+
+#endif // KIRAZ_COMPILESTATS_H
@@ -1,109 +1,349 @@
 
 #include "Compiler.h"
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
 
 #include <fmt/format.h>
 
-#include <resource/FILE_io_ki.h>
+#include <kiraz/CompileCache.h>
+#include <kiraz/MappedFile.h>
+#include <kiraz/ModuleInterface.h>
+#include <kiraz/Prelude.h>
+#include <kiraz/WatWriter.h>
+#include <kiraz/ir/ConstantFolding.h>
+#include <kiraz/ir/DeadCodeElimination.h>
 
-Node::Ptr SymbolTable::s_module_ki;
-Node::Ptr SymbolTable::s_module_io;
+Node::Ptr Scope::find(Symbol name) const {
+    if (! name) {
+        return nullptr;
+    }
 
-SymbolTable::~SymbolTable() {}
+    auto limit = size();
+    for (auto scope = this; scope; limit = scope->parent_size, scope = scope->parent.get()) {
+        if (auto symbol = scope->find_local(name, limit)) {
+            return symbol;
+        }
+    }
+    return nullptr;
+}
+
+Node::Ptr Scope::find_local(Symbol name, size_t limit) const {
+    if (m_slots.empty()) {
+        return nullptr;
+    }
 
-Compiler *Compiler::s_current;
+    const auto &slot = m_slots[probe(name)];
+    if (! slot.name) {
+        return nullptr;
+    }
+    if (slot.binding.seq < limit) {
+        return slot.binding.stmt;
+    }
+
+    for (auto replaced = m_replaced.rbegin(); replaced != m_replaced.rend(); ++replaced) {
+        if (replaced->second.seq < limit && replaced->first == name) {
+            return replaced->second.stmt;
+        }
+    }
+    return nullptr;
+}
 
-extern Token::Ptr curtoken;
+size_t Scope::probe(Symbol name) const {
+    auto mask = m_slots.size() - 1;
+    auto index = (std::hash<Symbol>{}(name) * 0x9E3779B97F4A7C15ull) & mask;
+    while (m_slots[index].name && m_slots[index].name != name) {
+        index = (index + 1) & mask;
+    }
+    return index;
+}
+
+void Scope::grow() {
+    auto slots = std::vector<Slot>(std::max<size_t>(8, m_slots.size() * 2));
+    std::swap(slots, m_slots);
+    for (auto &slot : slots) {
+        if (slot.name) {
+            m_slots[probe(slot.name)] = std::move(slot);
+        }
+    }
+}
+
+void Scope::set(Symbol name, Node::Ptr s) {
+    // keep the load factor at or below one half
+    if ((m_num_slots_used + 1) * 2 > m_slots.size()) {
+        grow();
+    }
+
+    auto &slot = m_slots[probe(name)];
+    if (slot.name) {
+        m_replaced.emplace_back(name, slot.binding);
+    } else {
+        slot.name = name;
+        ++m_num_slots_used;
+    }
+    slot.binding = {s, m_next_seq++};
+}
+
+SymbolTable::~SymbolTable() {}
+
+thread_local Compiler *Compiler::s_current;
 
 Compiler::Compiler() {
     assert(! s_current);
     s_current = this;
+    m_stats.set_arena(&m_arena);
+    m_state.stats = &m_stats;
+    yylex_init_extra(&m_state, &m_state.scanner);
     Node::reset_root();
+
+    m_passes.add<ir::ConstantFolding>();
+    m_passes.add<ir::DeadCodeElimination>();
 }
 
 Compiler::~Compiler() {
     if (buffer) {
-        yy_delete_buffer(buffer);
+        yy_delete_buffer(buffer, m_state.scanner);
         buffer = nullptr;
     }
-    reset_parser();
+    yylex_destroy(m_state.scanner);
     s_current = nullptr;
 }
 
 int Compiler::compile_file(const std::string &file_name) {
-    yyin = fopen(file_name.data(), "rb");
-    if (! yyin) {
-        perror(file_name.data());
-        return 2;
+    m_dependencies.clear();
+    MappedFile source;
+    {
+        CompileStats::Scope phase(m_stats, CompileStats::Phase::Read);
+        if (! source.open(file_name)) {
+            set_error(FF("Error: Unable to open file {}: {}", file_name, std::strerror(errno)));
+            return 2;
+        }
     }
 
-    yyparse();
-    auto root = Node::get_root();
-    reset();
+    // the scanner may write into the mapping, so the cache gets a copy of the pristine text
+    std::string text;
+    if (m_cache) {
+        text.assign(source.data(), source.size());
+        if (load_from_cache(text)) {
+            return 0;
+        }
+    }
 
-    return compile(root);
+    // the scanner works on the mapping itself, it has to stay alive until the parse is done
+    Node::Ptr root;
+    {
+        CompileStats::Scope phase(m_stats, CompileStats::Phase::Parse);
+        buffer = yy_scan_buffer(source.data(), source.get_buffer_size(), m_state.scanner);
+        assert(buffer);
+        yyparse(m_state.scanner);
+        root = Node::get_root();
+        reset();
+    }
+
+    return save_to_cache(text, compile(root));
 }
 
 int Compiler::compile_string(const std::string &code) {
-    buffer = yy_scan_string(code.data());
-    yyparse();
-    auto root = Node::get_root();
-    reset();
+    m_dependencies.clear();
+    if (load_from_cache(code)) {
+        return 0;
+    }
+
+    Node::Ptr root;
+    {
+        CompileStats::Scope phase(m_stats, CompileStats::Phase::Parse);
+        buffer = yy_scan_string(code.data(), m_state.scanner);
+        yyparse(m_state.scanner);
+        root = Node::get_root();
+        reset();
+    }
+
+    return save_to_cache(code, compile(root));
+}
 
-    return compile(root);
+void Compiler::add_dependency(const std::string &file_name, const ModuleInterface::Stamp &stamp) {
+    std::error_code ec;
+    auto path = std::filesystem::weakly_canonical(file_name, ec);
+    if (ec) {
+        path = std::filesystem::absolute(file_name, ec);
+    }
+    m_dependencies.push_back({ec ? file_name : path.string(), stamp});
+}
+
+std::string Compiler::get_cache_options() const {
+    std::string retval = m_target == Target::Wasm ? "wasm" : "wat";
+    for (const auto &name : m_entry_points) {
+        retval += FF(" entry={}", name);
+    }
+    for (const auto &timing : m_passes.get_timings()) {
+        retval += FF(" pass={}", timing.name);
+    }
+    return retval;
+}
+
+bool Compiler::load_from_cache(std::string_view source) {
+    if (! m_cache) {
+        return false;
+    }
+
+    std::string output;
+    if (! m_cache->lookup(get_cache_options(), source, output)) {
+        return false;
+    }
+
+    if (m_target == Target::Wasm) {
+        m_wasm_binary.assign(output.begin(), output.end());
+    }
+    else {
+        m_ctx.body().append(output);
+    }
+    return true;
+}
+
+int Compiler::save_to_cache(std::string_view source, int status) {
+    if (! m_cache || status != 0) {
+        return status;
+    }
+
+    if (m_target == Target::Wasm) {
+        m_cache->store(get_cache_options(), source, m_dependencies,
+                {reinterpret_cast<const char *>(m_wasm_binary.data()), m_wasm_binary.size()});
+    }
+    else {
+        m_cache->store(get_cache_options(), source, m_dependencies, m_ctx.body().str());
+    }
+    return status;
 }
 
 Node::Ptr Compiler::compile_module(const std::string &str) {
-    buffer = yy_scan_string(str.data());
-    yyparse();
-    auto retval = Node::pop_root();
+    CompileStats::Scope phase(m_stats, CompileStats::Phase::Parse);
+    buffer = yy_scan_string(str.data(), m_state.scanner);
+    Node::Ptr retval;
+    if (yyparse(m_state.scanner) == 0) {
+        retval = Node::pop_root();
+    }
     reset();
-    assert(retval);
     return retval;
 }
 
+const Node::Ptr &Compiler::get_module_io() {
+    if (! m_module_io) {
+        CompileStats::Scope phase(m_stats, CompileStats::Phase::Prelude);
+        m_module_io = Prelude::load_io();
+    }
+    return m_module_io;
+}
+
 void Compiler::reset_parser() {
-    curtoken.reset();
+    m_state.token = {};
+    m_state.colno = 0;
     Node::reset_root();
-    Token::colno = 0;
-    yylex_destroy();
+    yylex_destroy(m_state.scanner);
+    yylex_init_extra(&m_state, &m_state.scanner);
 }
 
 void Compiler::reset() {
     if (buffer) {
-        yy_delete_buffer(buffer);
+        yy_delete_buffer(buffer, m_state.scanner);
         buffer = nullptr;
     }
     reset_parser();
 }
 
 int Compiler::compile(Node::Ptr root) {
+    ++m_stats.num_compilations;
     if (! root) {
         return 1;
     }
 
     SymbolTable st(ScopeType::Module);
 
-    if (auto ret = root->compute_stmt_type(st)) {
+    if (CompileStats::Scope phase(m_stats, CompileStats::Phase::Check);
+            auto ret = root->compute_stmt_type(st)) {
         set_error(FF("Error at {}:{}: {}\n", ret->get_line(), ret->get_col(), ret->get_error()));
         Node::reset_root();
         return 1;
     }
 
-    if (auto ret = root->gen_wat(m_ctx)) {
-        set_error(fmt::format("WAT Generation Error: {}", ret->as_string()));
+    ir::Module module;
+    {
+        CompileStats::Scope phase(m_stats, CompileStats::Phase::Lower);
+        ir::Builder builder(module);
+        if (auto ret = root->gen_ir(builder)) {
+            set_error(FF("Code Generation Error at {}:{}: {}", ret->get_line(), ret->get_col(),
+                    ret->get_error()));
+            return 2;
+        }
+    }
+
+    if (! export_entry_points(module)) {
         return 2;
     }
 
+    {
+        CompileStats::Scope phase(m_stats, CompileStats::Phase::Optimize);
+        m_passes.run(module);
+    }
+
+    // wasm globals are initialized with constants, so the initializers have to fold into one
+    for (const auto &global : module.globals) {
+        if (! global.has_const_init()) {
+            set_error(FF("Code Generation Error: Module level variable '{}' needs a constant value",
+                    global.name));
+            return 2;
+        }
+    }
+
+    CompileStats::Scope phase(m_stats, CompileStats::Phase::Emit);
+    if (m_target == Target::Wasm) {
+        m_wasm_binary = WasmWriter::write(module);
+        m_stats.num_bytes_emitted += m_wasm_binary.size();
+    }
+    else {
+        auto size = m_ctx.body().size();
+        WatWriter::write(module, m_ctx.body());
+        m_stats.num_bytes_emitted += m_ctx.body().size() - size;
+    }
+
     return 0;
 }
 
+bool Compiler::export_entry_points(ir::Module &module) {
+    auto find = [&module](std::string_view name) {
+        return std::find_if(module.funcs.begin(), module.funcs.end(),
+                [name](const auto &func) { return func.name.str() == name; });
+    };
+
+    auto names = m_entry_points;
+    if (names.empty()) {
+        if (find("main") == module.funcs.end()) {
+            return true;
+        }
+        names.push_back("main");
+    }
+
+    for (auto &func : module.funcs) {
+        func.exported = false;
+    }
+    for (const auto &name : names) {
+        auto iter = find(name);
+        if (iter == module.funcs.end()) {
+            set_error(FF("Code Generation Error: Entry point '{}' is not defined", name));
+            return false;
+        }
+        iter->exported = true;
+    }
+    return true;
+}
+
 SymbolTable::SymbolTable()
         : m_symbols({
-                  std::make_shared<Scope>(Scope::SymTab{}, ScopeType::Module, nullptr),
+                  std::make_shared<Scope>(ScopeType::Module, nullptr),
           }) {
-    if (! s_module_io) {
-        s_module_io = Compiler::current()->compile_module(FILE_io_ki);
+    if (auto stats = get_stats()) {
+        ++stats->num_scopes;
     }
 }
 
@@ -111,6 +351,41 @@ SymbolTable::SymbolTable(ScopeType scope_type) : SymbolTable() {
     m_symbols.back()->scope_type = scope_type;
 }
 
+Symbol SymbolTable::add_import(std::shared_ptr<ModuleInterface> module) {
+    // names nobody interned yet can not be defined, so most are ruled out without a lookup
+    Symbol retval;
+    module->for_each_name([&](std::string_view text) {
+        auto name = get_names().find(text);
+        if (! retval && name && m_symbols.back()->find(name)) {
+            retval = name;
+        }
+    });
+    m_imports.push_back(std::move(module));
+    return retval;
+}
+
+Node::Ptr SymbolTable::find_import(Symbol name) const {
+    for (const auto &module : m_imports) {
+        if (auto retval = module->find(name)) {
+            return retval;
+        }
+    }
+    return nullptr;
+}
+
+Node::Ptr SymbolTable::get_module_io() {
+    return Compiler::current()->get_module_io();
+}
+
+Interner &SymbolTable::get_names() {
+    return Compiler::current()->get_parser_state().names;
+}
+
+CompileStats *SymbolTable::get_stats() {
+    auto compiler = Compiler::current();
+    return compiler ? &compiler->get_stats() : nullptr;
+}
+
 WasmContext::Coords WasmContext::add_to_memory(const std::string &s) {
     assert(!s.empty());
     uint32_t offset = m_memory.size();
@@ -1,10 +1,21 @@
+#ifndef KIRAZ_COMPILER_H
+#define KIRAZ_COMPILER_H
 
 #include <cassert>
 #include <map>
 #include <unordered_set>
+#include <utility>
 
+#include <kiraz/Arena.h>
+#include <kiraz/CompileCache.h>
+#include <kiraz/CompileStats.h>
+#include <kiraz/Interner.h>
 #include <kiraz/Node.h>
+#include <kiraz/OutputBuffer.h>
+#include <kiraz/ParserState.h>
 #include <kiraz/Token.h>
+#include <kiraz/WasmWriter.h>
+#include <kiraz/ir/PassManager.h>
 #include <iostream>
 #include <lexer.hpp>
 
@@ -15,42 +26,96 @@ enum class ScopeType {
     Method,
 };
 
+/**
+ * @brief Scope: One level of the symbol table. Instead of copying the enclosing scope on entry, a
+ *        scope links to its parent and remembers how many of the parent's bindings existed at that
+ *        point. Bindings the parent gains later stay invisible, so each scope behaves like a
+ *        snapshot of everything in view when it was entered.
+ */
 struct Scope {
-    using SymTab = std::map<std::string, Node::Ptr>;
+    using Ptr = std::shared_ptr<Scope>;
 
-    Scope(const std::map<std::string, Node::Ptr> &map, ScopeType stype, Node::Ptr s)
-            : symbols(map), scope_type(stype), stmt(s) {}
+    Scope(ScopeType stype, Node::Ptr s, Ptr p = nullptr)
+            : scope_type(stype), stmt(s), parent(p), parent_size(p ? p->size() : 0) {}
 
-    SymTab symbols;
     ScopeType scope_type;
     Node::Ptr stmt;
+    const Ptr parent;
+    const size_t parent_size;
 
-    auto find(const std::string &s) { return symbols.find(s); }
-    auto find(const std::string &s) const { return symbols.find(s); }
-    auto end() { return symbols.end(); }
-    auto end() const { return symbols.end(); }
+    /**
+     * @brief size: Number of bindings ever made in this scope, overwritten ones included.
+     */
+    size_t size() const { return m_next_seq; }
 
-    decltype(auto) operator[](const std::string &s) { return (symbols[s]); }
-    Node::SymTabEntry get_symbol(const std::string &name) const {
-        auto iter = symbols.find(name);
-        if (iter == symbols.end()) {
-            return name;
+    /**
+     * @brief find: Looks the name up in this scope and the visible part of its ancestors.
+     * @return The bound statement, or nullptr if the name is not in view
+     */
+    Node::Ptr find(Symbol name) const;
+
+    /**
+     * @brief set: Binds the name in this scope, replacing a previous local binding if any.
+     */
+    void set(Symbol name, Node::Ptr s);
+
+    Node::SymTabEntry get_symbol(Symbol name) const {
+        auto symbol = find(name);
+        if (! symbol) {
+            return name.str();
+        }
+        return {name.str(), symbol};
+    }
+
+    template <typename F>
+    void for_each_local(F &&f) const {
+        for (const auto &slot : m_slots) {
+            if (slot.name) {
+                f(slot.name.str(), slot.binding.stmt);
+            }
         }
-        return {name, iter->second};
     }
+
+private:
+    struct Binding {
+        Node::Ptr stmt;
+        size_t seq = 0;
+    };
+
+    struct Slot {
+        Symbol name;
+        Binding binding;
+    };
+
+    Node::Ptr find_local(Symbol name, size_t limit) const;
+    size_t probe(Symbol name) const;
+    void grow();
+
+    /* Open addressing with linear probing, the capacity is zero or a power of two */
+    std::vector<Slot> m_slots;
+    size_t m_num_slots_used = 0;
+
+    /* Bindings that were overwritten, kept for the child scopes that saw them */
+    std::vector<std::pair<Symbol, Binding>> m_replaced;
+    size_t m_next_seq = 0;
 };
 
 class SymbolTable {
 public:
+    /* Leaves the scope on destruction, a moved from ScopeRef leaves nothing */
     struct ScopeRef {
-        ScopeRef(SymbolTable &s) : symtab(s) {}
+        ScopeRef(SymbolTable &s) : symtab(&s) {}
         ScopeRef(const ScopeRef &) = delete;
-        ScopeRef(ScopeRef &&) = default;
+        ScopeRef(ScopeRef &&other) : symtab(std::exchange(other.symtab, nullptr)) {}
         ScopeRef &operator=(const ScopeRef &) = delete;
 
-        ~ScopeRef() { symtab.exit_scope(); }
+        ~ScopeRef() {
+            if (symtab) {
+                symtab->exit_scope();
+            }
+        }
 
-        SymbolTable &symtab;
+        SymbolTable *symtab;
     };
 
     friend class ScopeRef;
@@ -65,74 +130,66 @@ public:
         for (size_t i = 0; i < m_symbols.size(); ++i) {
             const auto &scope = m_symbols[i];
             std::cout << "Scope " << i << ": Type = " << static_cast<int>(scope->scope_type) << std::endl;
-            for (const auto &symbol : scope->symbols) {
-                std::cout << "  Symbol: " << symbol.first << " -> ";
-                if (symbol.second) {
-                    std::cout << symbol.second->as_string();
+            scope->for_each_local([](const std::string &name, const Node::Ptr &stmt) {
+                std::cout << "  Symbol: " << name << " -> ";
+                if (stmt) {
+                    std::cout << stmt->as_string();
                 } else {
                     std::cout << "null";
                 }
                 std::cout << std::endl;
-            }
+            });
             std::cout << std::endl;
         }
         std::cout << "=========================" << std::endl;
     }
 
-    Node::Ptr lookup(const std::string& name) const {
-        if (m_symbols.empty()) {
-            return nullptr;
+    Node::Ptr lookup(Symbol name) const {
+        if (auto stats = get_stats()) {
+            ++stats->num_lookups;
         }
-
-        for (auto it = m_symbols.rbegin(); it != m_symbols.rend(); ++it) {
-            const auto &scope = *it;
-            if(scope) {
-                auto symbol = scope->find(name);
-                if (symbol != scope->end()) {
-                    return symbol->second;
-                }
-            }
-        }
-        return nullptr;
-    }
-
-    Node::Ptr lookup_in_current_scope(const std::string &name) const {
         if (m_symbols.empty()) {
             return nullptr;
         }
-
-        const auto &current_scope = m_symbols.back();
-        if (current_scope) {
-            auto symbol = current_scope->find(name);
-            if (symbol != current_scope->end()) {
-                return symbol->second; 
-            }
+        if (auto retval = m_symbols.back()->find(name); retval || m_imports.empty()) {
+            return retval;
         }
-        return nullptr;
+        return find_import(name);
     }
+    Node::Ptr lookup(const std::string &name) const { return lookup(get_names().find(name)); }
 
+    /* The current scope sees everything in view of its ancestors, so this is the same walk */
+    Node::Ptr lookup_in_current_scope(Symbol name) const { return lookup(name); }
+    Node::Ptr lookup_in_current_scope(const std::string &name) const { return lookup(name); }
 
     bool is_builtin(const std::string &name) {
         static const std::unordered_set<std::string> builtins = {"and", "or", "not", "Boolean", "Integer64", "Void", "String" };
         return builtins.find(name) != builtins.end();
     }
 
+    Node::Ptr add_symbol(Symbol name, Node::Ptr m) {
+        assert(name);
+        m_symbols.back()->set(name, m);
+        return m;
+    }
     Node::Ptr add_symbol(const std::string &name, Node::Ptr m) {
         assert(! name.empty());
-        (*m_symbols.back())[name] = m;
-        return m;
+        return add_symbol(get_names().intern(name), m);
     }
 
+    Node::SymTabEntry get_symbol(Symbol name) const { return m_symbols.back()->get_symbol(name); }
     Node::SymTabEntry get_symbol(const std::string &name) const {
-        return m_symbols.back()->get_symbol(name);
+        auto entry = get_symbol(get_names().find(name));
+        entry.name = name;
+        return entry;
     }
 
-    const auto &get_symbols() const { return m_symbols.back()->symbols; }
-
     ScopeRef enter_scope(ScopeType scope_type, Node::Ptr stmt) {
         assert(stmt->get_cur_symtab() == m_symbols.back());
-        m_symbols.emplace_back(
-                std::make_shared<Scope>(m_symbols.back()->symbols, scope_type, stmt));
+        if (auto stats = get_stats()) {
+            ++stats->num_scopes;
+        }
+        m_symbols.emplace_back(std::make_shared<Scope>(scope_type, stmt, m_symbols.back()));
         assert(m_symbols.size() > 1);
         return ScopeRef(*this);
     }
@@ -142,26 +199,35 @@ public:
     auto get_scope_type() const { return m_symbols.back()->scope_type; }
     auto get_scope_stmt() const { return m_symbols.back()->stmt; }
 
-    static auto get_module_io() { return s_module_io; }
+    static Node::Ptr get_module_io();
+
+    /**
+     * @brief add_import: Makes the declarations of an imported module visible to the lookups no
+     *        scope answers. They are decoded the first time they are looked up.
+     * @return The first name of the module that the current scope already defines, if any
+     */
+    Symbol add_import(std::shared_ptr<ModuleInterface> module);
+
+    /**
+     * @brief get_names: Returns the identifier interner of the current compilation.
+     */
+    static Interner &get_names();
+
+    /**
+     * @brief get_stats: Returns the statistics of the current compilation, nullptr outside one.
+     */
+    static CompileStats *get_stats();
 
 private:
     void exit_scope() { m_symbols.pop_back(); }
+    Node::Ptr find_import(Symbol name) const;
 
-    std::vector<std::shared_ptr<Scope>> m_symbols;
-
-    static Node::Ptr s_module_ki;
-    static Node::Ptr s_module_io;
+    std::vector<Scope::Ptr> m_symbols;
+    std::vector<std::shared_ptr<ModuleInterface>> m_imports;
 };
 
 class WasmContext {
-    struct Streams {
-        std::stringstream locals;
-        std::stringstream body;
-    };
-
 public:
-    WasmContext() : m_streams(1) {}
-
     struct Coords {
         Coords(uint32_t o = 0, uint32_t l = 0) : offset(o), length(l) {}
         uint32_t offset;
@@ -187,52 +253,124 @@ public:
      */
     Coords add_to_memory(uint32_t u);
 
-    auto &body() { return m_streams.back().body; }
-    auto &body() const { return m_streams.back().body; }
-    auto &locals() { return m_streams.back().locals; }
-
-    void push() { m_streams.emplace_back(); }
-    void pop() {
-        assert(m_streams.size() >= 2);
-        {
-            auto iter = m_streams.rbegin();
-            auto &source = *iter;
-            auto &target = *std::next(iter);
-            target.body << source.locals.str();
-            target.body << source.body.str();
-        }
-        m_streams.pop_back();
-        assert(m_streams.size() > 0 || m_streams.back().locals.str().empty());
-    }
+    auto &body() { return m_body; }
+    auto &body() const { return m_body; }
 
 private:
     std::vector<unsigned char> m_memory;
-    std::vector<Streams> m_streams;
+    OutputBuffer m_body;
 };
 
+/**
+ * @brief Compiler: Owns a reentrant scanner and all parser state, so independent instances may
+ *        run concurrently on separate threads. At most one instance may be alive per thread.
+ *        Nodes created while it is alive live in its arena, so no Node::Ptr may outlive it.
+ */
 class Compiler {
 public:
+    /* Code generation backend, WAT text or a binary module */
+    enum class Target {
+        Wat,
+        Wasm,
+    };
+
     static Compiler *current() { return s_current; }
     Compiler();
 
     int compile_file(const std::string &file_name);
     int compile_string(const std::string &str);
+
+    /**
+     * @brief compile_module: Parses a module without checking it.
+     * @return nullptr if the module does not parse, get_error() tells why
+     */
     Node::Ptr compile_module(const std::string &str);
 
-    static void reset_parser();
+    void reset_parser();
     void reset();
     void set_error(const std::string &str) { m_error = str; }
     const auto &get_error() const { return m_error; }
     const auto &get_wasm_ctx() const { return m_ctx; }
 
+    void set_target(Target target) { m_target = target; }
+    auto get_target() const { return m_target; }
+
+    /**
+     * @brief get_wasm_binary: Returns the module built by the last compilation for Target::Wasm.
+     */
+    const auto &get_wasm_binary() const { return m_wasm_binary; }
+
+    /**
+     * @brief set_entry_points: Names the functions the module exports, the functions none of them
+     *        reaches are left out. By default a module with a main function only exports main,
+     *        other modules export all of their functions.
+     */
+    void set_entry_points(std::vector<std::string> names) { m_entry_points = std::move(names); }
+
+    /**
+     * @brief set_cache: Reuses the output of earlier compilations of the same source with the
+     *        same options, and saves the output of successful ones. The cache is not owned and
+     *        may be shared with compilers on other threads, nullptr disables caching.
+     */
+    void set_cache(CompileCache *cache) { m_cache = cache; }
+
+    /**
+     * @brief add_dependency: Records a file the output depends on besides the source, so cached
+     *        output is not reused once it changes. The path is made canonical, as a cache entry
+     *        may be looked up from another working directory.
+     */
+    void add_dependency(const std::string &file_name, const ModuleInterface::Stamp &stamp);
+
+    /**
+     * @brief get_passes: Returns the optimisation pipeline run on the IR of every compilation,
+     *        along with the time spent in each pass.
+     */
+    auto &get_passes() { return m_passes; }
+    const auto &get_passes() const { return m_passes; }
+
+    /**
+     * @brief get_stats: Returns the time and work spent in each phase, summed over every
+     *        compilation of this instance.
+     */
+    auto &get_stats() { return m_stats; }
+    const auto &get_stats() const { return m_stats; }
+
+    auto &get_parser_state() { return m_state; }
+    auto &get_arena() { return m_arena; }
+    auto get_scanner() const { return m_state.scanner; }
+
+    /**
+     * @brief get_module_io: Returns the precompiled io module, decoding it on first use.
+     */
+    const Node::Ptr &get_module_io();
+
     ~Compiler();
 
 protected:
     int compile(Node::Ptr root);
 
 private:
+    bool export_entry_points(ir::Module &module);
+
+    std::string get_cache_options() const;
+    bool load_from_cache(std::string_view source);
+    int save_to_cache(std::string_view source, int status);
+
+    /* Backs every node created through this instance, declared first so it is released last */
+    Arena m_arena;
+    CompileStats m_stats;
     YY_BUFFER_STATE buffer = nullptr;
+    ParserState m_state;
+    Node::Ptr m_module_io;
     std::string m_error;
     WasmContext m_ctx;
-    static Compiler *s_current;
+    Target m_target = Target::Wat;
+    ir::PassManager m_passes;
+    std::vector<std::string> m_entry_points;
+    CompileCache *m_cache = nullptr;
+    std::vector<CompileCache::Dependency> m_dependencies;
+    WasmWriter::Bytes m_wasm_binary;
+    static thread_local Compiler *s_current;
 };
+
+#endif // KIRAZ_COMPILER_H
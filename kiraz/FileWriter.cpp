@@ -0,0 +1,30 @@
+
+#include "FileWriter.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <random>
+
+#include <fmt/format.h>
+
+#include <kiraz/Trace.h>
+
+bool FileWriter::replace(const std::string &file_name, std::string_view contents) {
+    Trace::Span span("write_file", file_name);
+    auto tmp_name = fmt::format("{}.{:x}.tmp", file_name, std::random_device{}());
+
+    auto file = fopen(tmp_name.data(), "wb");
+    if (! file) {
+        return false;
+    }
+    bool ok = fwrite(contents.data(), 1, contents.size(), file) == contents.size();
+    ok = fclose(file) == 0 && ok;
+
+    if (! ok || std::rename(tmp_name.data(), file_name.data()) != 0) {
+        auto err = errno;
+        std::remove(tmp_name.data());
+        errno = err;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,21 @@
+#ifndef KIRAZ_FILEWRITER_H
+#define KIRAZ_FILEWRITER_H
+
+#include <string>
+#include <string_view>
+
+/**
+ * @brief FileWriter: Writes the files the compiler shares between runs, the compile cache entries
+ *        and the module interfaces.
+ */
+class FileWriter {
+public:
+    /**
+     * @brief replace: Writes the given contents to a temporary file and renames it over the
+     *        given one, so concurrent readers see either the old or the new contents in full.
+     * @return false with errno set if the file could not be written
+     */
+    static bool replace(const std::string &file_name, std::string_view contents);
+};
+
+#endif // KIRAZ_FILEWRITER_H
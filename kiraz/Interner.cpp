@@ -0,0 +1,23 @@
+
+#include "Interner.h"
+
+Symbol Interner::intern(std::string_view text) {
+    auto iter = m_index.find(text);
+    if (iter != m_index.end()) {
+        return Symbol(iter->second);
+    }
+
+    // ids start at 1, 0 is reserved for the null symbol
+    auto id = uint32_t(m_entries.size() + 1);
+    auto &entry = m_entries.emplace_back(Symbol::Entry{std::string(text), id});
+    m_index.emplace(entry.text, &entry);
+    return Symbol(&entry);
+}
+
+Symbol Interner::find(std::string_view text) const {
+    auto iter = m_index.find(text);
+    if (iter == m_index.end()) {
+        return {};
+    }
+    return Symbol(iter->second);
+}
@@ -0,0 +1,91 @@
+#ifndef KIRAZ_INTERNER_H
+#define KIRAZ_INTERNER_H
+
+#include <cstdint>
+#include <deque>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include <fmt/format.h>
+
+/**
+ * @brief Symbol: Handle to a string owned by an Interner. Two symbols of the same Interner are
+ *        equal exactly when their strings are, so comparing and hashing them is O(1). The handle
+ *        points at the interned entry, which keeps the text reachable without the Interner.
+ */
+class Symbol {
+public:
+    struct Entry {
+        std::string text;
+        uint32_t id;
+    };
+
+    Symbol() = default;
+    explicit Symbol(const Entry *entry) : m_entry(entry) {}
+
+    explicit operator bool() const { return m_entry != nullptr; }
+
+    /**
+     * @brief get_id: Small integer that is unique among the symbols of one Interner, 0 if null.
+     */
+    uint32_t get_id() const { return m_entry ? m_entry->id : 0; }
+
+    const std::string &str() const {
+        static const std::string empty;
+        return m_entry ? m_entry->text : empty;
+    }
+    operator const std::string &() const { return str(); }
+
+    bool operator==(const Symbol &other) const { return m_entry == other.m_entry; }
+    bool operator!=(const Symbol &other) const { return m_entry != other.m_entry; }
+
+private:
+    const Entry *m_entry = nullptr;
+};
+
+inline std::ostream &operator<<(std::ostream &os, const Symbol &symbol) {
+    return os << symbol.str();
+}
+
+template <>
+struct fmt::formatter<Symbol> : fmt::formatter<std::string_view> {
+    format_context::iterator format(const Symbol &symbol, format_context &ctx) const {
+        return fmt::formatter<std::string_view>::format(symbol.str(), ctx);
+    }
+};
+
+template <>
+struct std::hash<Symbol> {
+    size_t operator()(const Symbol &symbol) const { return symbol.get_id(); }
+};
+
+/**
+ * @brief Interner: Owns one copy of every distinct identifier seen during a compilation and hands
+ *        out Symbol handles to them. Entries live as long as the Interner.
+ */
+class Interner {
+public:
+    Interner() = default;
+    Interner(const Interner &) = delete;
+    Interner &operator=(const Interner &) = delete;
+
+    /**
+     * @brief intern: Returns the symbol for the given text, adding it on first sight.
+     */
+    Symbol intern(std::string_view text);
+
+    /**
+     * @brief find: Returns the symbol for the given text if it was interned, otherwise null.
+     */
+    Symbol find(std::string_view text) const;
+
+    auto get_size() const { return m_entries.size(); }
+
+private:
+    std::deque<Symbol::Entry> m_entries;
+    std::unordered_map<std::string_view, const Symbol::Entry *> m_index;
+};
+
+#endif // KIRAZ_INTERNER_H
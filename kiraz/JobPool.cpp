@@ -0,0 +1,111 @@
+
+#include "JobPool.h"
+#include <cassert>
+
+JobPool::JobPool(size_t num_workers) {
+    if (num_workers == 0) {
+        num_workers = 1;
+    }
+
+    for (size_t i = 0; i < num_workers; ++i) {
+        m_queues.emplace_back(std::make_unique<Queue>());
+    }
+
+    for (size_t i = 0; i < num_workers; ++i) {
+        m_threads.emplace_back(&JobPool::run, this, i);
+    }
+}
+
+JobPool::~JobPool() {
+    {
+        std::lock_guard lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv_work.notify_all();
+
+    for (auto &thread : m_threads) {
+        thread.join();
+    }
+}
+
+void JobPool::submit(Job job) {
+    size_t index;
+    {
+        std::lock_guard lock(m_mutex);
+        index = m_next++ % m_queues.size();
+    }
+
+    {
+        auto &queue = *m_queues[index];
+        std::lock_guard lock(queue.mutex);
+        queue.jobs.emplace_back(std::move(job));
+    }
+
+    {
+        std::lock_guard lock(m_mutex);
+        ++m_queued;
+        ++m_pending;
+    }
+    m_cv_work.notify_one();
+}
+
+void JobPool::wait() {
+    std::unique_lock lock(m_mutex);
+    m_cv_done.wait(lock, [this] { return m_pending == 0; });
+}
+
+bool JobPool::take(size_t index, Job &job) {
+    // own deque first, newest job
+    {
+        auto &queue = *m_queues[index];
+        std::lock_guard lock(queue.mutex);
+        if (! queue.jobs.empty()) {
+            job = std::move(queue.jobs.back());
+            queue.jobs.pop_back();
+            return true;
+        }
+    }
+
+    // then steal the oldest job of a sibling
+    for (size_t i = 1; i < m_queues.size(); ++i) {
+        auto &queue = *m_queues[(index + i) % m_queues.size()];
+        std::lock_guard lock(queue.mutex);
+        if (! queue.jobs.empty()) {
+            job = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void JobPool::run(size_t index) {
+    for (;;) {
+        {
+            std::unique_lock lock(m_mutex);
+            m_cv_work.wait(lock, [this] { return m_stop || m_queued > 0; });
+            if (m_queued == 0) {
+                assert(m_stop);
+                return;
+            }
+
+            // reserve one of the queued jobs, so the search below can not come back empty-handed
+            --m_queued;
+        }
+
+        Job job;
+        while (! take(index, job)) {
+            std::this_thread::yield();
+        }
+
+        job();
+
+        {
+            std::lock_guard lock(m_mutex);
+            if (--m_pending == 0) {
+                m_cv_done.notify_all();
+            }
+        }
+    }
+}
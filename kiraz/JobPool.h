@@ -0,0 +1,58 @@
+#ifndef KIRAZ_JOBPOOL_H
+#define KIRAZ_JOBPOOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief JobPool: Fixed-size thread pool with one job deque per worker. Workers take jobs from the
+ *        back of their own deque and steal from the front of the others' once theirs runs dry.
+ */
+class JobPool {
+public:
+    using Job = std::function<void()>;
+
+    explicit JobPool(size_t num_workers = std::thread::hardware_concurrency());
+    JobPool(const JobPool &) = delete;
+    JobPool &operator=(const JobPool &) = delete;
+    ~JobPool();
+
+    /**
+     * @brief submit: Queues a job, distributing jobs round-robin over the worker deques.
+     */
+    void submit(Job job);
+
+    /**
+     * @brief wait: Blocks until every job submitted so far has finished running.
+     */
+    void wait();
+
+    auto get_num_workers() const { return m_threads.size(); }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    void run(size_t index);
+    bool take(size_t index, Job &job);
+
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv_work;
+    std::condition_variable m_cv_done;
+    size_t m_next = 0;
+    size_t m_queued = 0;
+    size_t m_pending = 0;
+    bool m_stop = false;
+};
+
+#endif // KIRAZ_JOBPOOL_H
@@ -0,0 +1,114 @@
+
+#include "MappedFile.h"
+
+#include <cerrno>
+#include <cstdio>
+
+#include <kiraz/Trace.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+#ifndef _WIN32
+
+bool MappedFile::open(const std::string &file_name) {
+    Trace::Span span("open_file", file_name);
+    close();
+
+    auto fd = ::open(file_name.data(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        auto err = errno;
+        ::close(fd);
+        errno = err;
+        return false;
+    }
+
+    auto size = size_t(st.st_size);
+    auto page_size = size_t(sysconf(_SC_PAGESIZE));
+    auto mapped_size = (size + 2 + page_size - 1) / page_size * page_size;
+
+    // reserve zeroed pages for the contents plus the terminating NULs, then lay the file over
+    // them. The tail stays anonymous, so reading past the end of the file never faults.
+    auto base = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+            -1, 0);
+    if (base == MAP_FAILED) {
+        auto err = errno;
+        ::close(fd);
+        errno = err;
+        return false;
+    }
+
+    if (size > 0
+            && mmap(base, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0)
+                    == MAP_FAILED) {
+        auto err = errno;
+        munmap(base, mapped_size);
+        ::close(fd);
+        errno = err;
+        return false;
+    }
+    ::close(fd);
+
+    // the scanner goes through the input front to back exactly once
+    madvise(base, mapped_size, MADV_SEQUENTIAL);
+
+    m_data = static_cast<char *>(base);
+    m_size = size;
+    m_mapped_size = mapped_size;
+    return true;
+}
+
+void MappedFile::close() {
+    if (m_mapped_size) {
+        munmap(m_data, m_mapped_size);
+        m_mapped_size = 0;
+    }
+    m_fallback.clear();
+    m_data = nullptr;
+    m_size = 0;
+}
+
+#else
+
+bool MappedFile::open(const std::string &file_name) {
+    Trace::Span span("open_file", file_name);
+    close();
+
+    auto file = fopen(file_name.data(), "rb");
+    if (! file) {
+        return false;
+    }
+
+    char chunk[64 * 1024];
+    size_t num_read;
+    while ((num_read = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        m_fallback.insert(m_fallback.end(), chunk, chunk + num_read);
+    }
+    fclose(file);
+
+    m_size = m_fallback.size();
+    m_fallback.resize(m_size + 2, '\0');
+    m_data = m_fallback.data();
+    return true;
+}
+
+void MappedFile::close() {
+    m_fallback.clear();
+    m_data = nullptr;
+    m_size = 0;
+}
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef KIRAZ_MAPPEDFILE_H
+#define KIRAZ_MAPPEDFILE_H
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief MappedFile: Source file mapped privately into memory and followed by the two NUL bytes
+ *        that yy_scan_buffer expects, so the scanner can work on it without copying it first.
+ *        The mapping is copy-on-write: the scanner may write into it, the file never changes.
+ *        Platforms without mmap read the file into an owned buffer instead.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile();
+
+    /**
+     * @brief open: Maps the given file, replacing any previous mapping.
+     * @return false with errno set if the file could not be opened or mapped
+     */
+    bool open(const std::string &file_name);
+
+    /**
+     * @brief data: Start of the file contents, writable and NUL terminated twice.
+     */
+    char *data() { return m_data; }
+
+    /**
+     * @brief size: Size of the file contents, not counting the terminating NULs.
+     */
+    size_t size() const { return m_size; }
+
+    /**
+     * @brief get_buffer_size: Size to hand to yy_scan_buffer, including the terminating NULs.
+     */
+    size_t get_buffer_size() const { return m_size + 2; }
+
+private:
+    void close();
+
+    char *m_data = nullptr;
+    size_t m_size = 0;
+    size_t m_mapped_size = 0;
+    std::vector<char> m_fallback;
+};
+
+#endif // KIRAZ_MAPPEDFILE_H
@@ -0,0 +1,311 @@
+
+#include "ModuleInterface.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include <kiraz/Compiler.h>
+#include <kiraz/FileWriter.h>
+#include <kiraz/Prelude.h>
+#include <kiraz/ast/Boolean.h>
+#include <kiraz/ast/Identifier.h>
+#include <kiraz/ast/Literal.h>
+#include <kiraz/ast/Statement.h>
+
+namespace {
+
+constexpr char MAGIC[4] = {'K', 'Z', 'I', 1};
+constexpr size_t HEADER_SIZE = sizeof(MAGIC) + 8 + 8 + 4;
+constexpr size_t ENTRY_SIZE = 4 * 4;
+
+void put_u32(Prelude::Bytes &out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(value >> (8 * i));
+    }
+}
+
+void put_u64(Prelude::Bytes &out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(value >> (8 * i));
+    }
+}
+
+uint64_t get_uint(std::string_view data, size_t offset, size_t size) {
+    uint64_t retval = 0;
+    for (size_t i = 0; i < size; ++i) {
+        retval |= uint64_t(uint8_t(data[offset + i])) << (8 * i);
+    }
+    return retval;
+}
+
+Node::Ptr get_name(const Node::Ptr &decl) {
+    if (auto func = std::dynamic_pointer_cast<ast::FunctionStatement>(decl)) {
+        return func->get_name();
+    }
+    if (auto cls = std::dynamic_pointer_cast<ast::ClassStatement>(decl)) {
+        return cls->get_name();
+    }
+    if (auto let = std::dynamic_pointer_cast<ast::LetStatement>(decl)) {
+        return let->get_identifier();
+    }
+    return nullptr;
+}
+
+/* The part of a statement that importers see, nullptr if it declares nothing they could use */
+Node::Ptr get_declaration(const Node::Ptr &stmt) {
+    if (auto func = std::dynamic_pointer_cast<ast::FunctionStatement>(stmt)) {
+        return Node::make<ast::FunctionStatement>(
+                func->get_name(), func->get_parameters(), func->get_return_type(), nullptr);
+    }
+
+    if (auto cls = std::dynamic_pointer_cast<ast::ClassStatement>(stmt)) {
+        std::shared_ptr<ast::StatementList> members;
+        for (const auto &member : ast::StatementList::statements_of(cls->get_stmts())) {
+            auto decl = get_declaration(member);
+            if (! decl) {
+                continue;
+            }
+            if (members) {
+                members->append(decl);
+            }
+            else {
+                members = Node::make<ast::StatementList>(decl);
+            }
+        }
+        return Node::make<ast::ClassStatement>(cls->get_name(), members, cls->get_parent_class());
+    }
+
+    if (auto let = std::dynamic_pointer_cast<ast::LetStatement>(stmt)) {
+        auto value = let->get_value();
+        if (std::dynamic_pointer_cast<ast::Integer>(value)
+                || std::dynamic_pointer_cast<ast::Boolean>(value)) {
+            return stmt;
+        }
+
+        // without a checker run only literals know their type
+        auto type = let->get_type();
+        if (! type && value) {
+            auto builtin = std::dynamic_pointer_cast<const ast::BuiltinType>(value->get_stmt_type());
+            if (builtin) {
+                type = Node::make<ast::Identifier>(
+                        SymbolTable::get_names().intern(builtin->get_name()));
+            }
+        }
+        if (! type) {
+            return nullptr;
+        }
+        return Node::make<ast::LetStatement>(let->get_identifier(), type, nullptr);
+    }
+
+    return nullptr;
+}
+
+/* Classes and functions build their own symbol tables, the enclosing one is not touched */
+Node::Ptr prepare(const Node::Ptr &decl) {
+    if (! decl) {
+        return nullptr;
+    }
+    SymbolTable scratch(ScopeType::Module);
+    if (decl->add_to_symtab_ordered(scratch)) {
+        return nullptr;
+    }
+    return decl;
+}
+
+} // namespace
+
+bool ModuleInterface::Stamp::of(const std::string &file_name, Stamp &out) {
+    std::error_code ec;
+    auto size = std::filesystem::file_size(file_name, ec);
+    if (ec) {
+        return false;
+    }
+    auto mtime = std::filesystem::last_write_time(file_name, ec);
+    if (ec) {
+        return false;
+    }
+
+    out.size = size;
+    out.mtime = mtime.time_since_epoch().count();
+    return true;
+}
+
+std::string ModuleInterface::get_file_name(const std::string &source_name) {
+    return std::filesystem::path(source_name).replace_extension(".kzi").string();
+}
+
+bool ModuleInterface::write(const std::string &file_name, const Node::Ptr &module,
+        const Stamp &stamp) {
+    struct Decl {
+        std::string_view name;
+        Prelude::Bytes code;
+    };
+
+    std::vector<Decl> decls;
+    auto stmts = std::dynamic_pointer_cast<ast::Module>(module);
+    for (const auto &stmt : ast::StatementList::statements_of(stmts ? stmts->get_statements()
+                                                                     : nullptr)) {
+        auto decl = get_declaration(stmt);
+        auto id = std::dynamic_pointer_cast<ast::Identifier>(get_name(decl));
+        if (! id) {
+            continue;
+        }
+
+        Decl entry{id->get_name().str()};
+        if (Prelude::encode(decl, entry.code)) {
+            continue;
+        }
+        decls.push_back(std::move(entry));
+    }
+
+    // the first declaration of a name wins, as it does in the symbol table
+    std::stable_sort(decls.begin(), decls.end(),
+            [](const Decl &a, const Decl &b) { return a.name < b.name; });
+    decls.erase(std::unique(decls.begin(), decls.end(),
+                        [](const Decl &a, const Decl &b) { return a.name == b.name; }),
+            decls.end());
+
+    Prelude::Bytes out(MAGIC, MAGIC + sizeof(MAGIC));
+    put_u64(out, stamp.size);
+    put_u64(out, stamp.mtime);
+    put_u32(out, decls.size());
+
+    size_t offset = HEADER_SIZE + ENTRY_SIZE * decls.size();
+    for (const auto &decl : decls) {
+        put_u32(out, offset);
+        put_u32(out, decl.name.size());
+        put_u32(out, offset + decl.name.size());
+        put_u32(out, decl.code.size());
+        offset += decl.name.size() + decl.code.size();
+    }
+    for (const auto &decl : decls) {
+        out.insert(out.end(), decl.name.begin(), decl.name.end());
+        out.insert(out.end(), decl.code.begin(), decl.code.end());
+    }
+
+    return FileWriter::replace(
+            file_name, {reinterpret_cast<const char *>(out.data()), out.size()});
+}
+
+bool ModuleInterface::open(const std::string &file_name, const Stamp &stamp) {
+    m_num_decls = 0;
+    m_decoded.clear();
+    if (! m_file.open(file_name)) {
+        return false;
+    }
+
+    std::string_view data(m_file.data(), m_file.size());
+    if (data.size() < HEADER_SIZE || data.substr(0, sizeof(MAGIC)) != std::string_view(MAGIC, 4)
+            || get_uint(data, 4, 8) != stamp.size
+            || int64_t(get_uint(data, 12, 8)) != stamp.mtime) {
+        return false;
+    }
+
+    auto num_decls = get_uint(data, 20, 4);
+    if ((data.size() - HEADER_SIZE) / ENTRY_SIZE < num_decls) {
+        return false;
+    }
+
+    // the index is small next to the declarations, checking it here spares get_entry the checks
+    for (size_t pos = HEADER_SIZE; pos < HEADER_SIZE + num_decls * ENTRY_SIZE; pos += 8) {
+        auto offset = get_uint(data, pos, 4);
+        auto size = get_uint(data, pos + 4, 4);
+        if (offset > data.size() || size > data.size() - offset) {
+            return false;
+        }
+    }
+    m_num_decls = num_decls;
+    return true;
+}
+
+bool ModuleInterface::load(const std::string &source_name, const Stamp &stamp) {
+    m_source_name = source_name;
+    m_stamp = stamp;
+    m_rebuilt = false;
+    return open(get_file_name(source_name), stamp) || build();
+}
+
+/* Parses the source and writes the interface again, the declarations decoded so far are kept */
+bool ModuleInterface::build() {
+    std::ifstream file(m_source_name, std::ios::in | std::ios::binary);
+    if (! file.is_open()) {
+        return false;
+    }
+    std::string source(
+            (std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    auto module = std::dynamic_pointer_cast<ast::Module>(
+            Compiler::current()->compile_module(source));
+    if (! module) {
+        return false;
+    }
+
+    auto decoded = std::move(m_decoded);
+    auto file_name = get_file_name(m_source_name);
+    if (! write(file_name, module, m_stamp) || ! open(file_name, m_stamp)) {
+        // serve the parsed module itself, the first declaration of a name wins
+        m_num_decls = 0;
+        m_decoded.clear();
+        for (const auto &stmt : ast::StatementList::statements_of(module->get_statements())) {
+            auto id = std::dynamic_pointer_cast<ast::Identifier>(get_name(stmt));
+            if (id && ! m_decoded.contains(id->get_name())) {
+                m_decoded.emplace(id->get_name(), prepare(stmt));
+            }
+        }
+    }
+
+    // nodes already handed out stay in use, so they must keep answering for their names
+    decoded.merge(m_decoded);
+    m_decoded = std::move(decoded);
+    return true;
+}
+
+ModuleInterface::Entry ModuleInterface::get_entry(size_t index) {
+    std::string_view data(m_file.data(), m_file.size());
+    auto pos = HEADER_SIZE + index * ENTRY_SIZE;
+    return {data.substr(get_uint(data, pos, 4), get_uint(data, pos + 4, 4)),
+            data.substr(get_uint(data, pos + 8, 4), get_uint(data, pos + 12, 4))};
+}
+
+Node::Ptr ModuleInterface::find(Symbol name) {
+    if (! name) {
+        return nullptr;
+    }
+    if (auto iter = m_decoded.find(name); iter != m_decoded.end()) {
+        return iter->second;
+    }
+    if (! m_num_decls) {
+        return nullptr;
+    }
+
+    std::string_view key = name.str();
+    size_t first = 0;
+    size_t count = m_num_decls;
+    while (count > 0) {
+        auto step = count / 2;
+        if (get_entry(first + step).name < key) {
+            first += step + 1;
+            count -= step + 1;
+        }
+        else {
+            count = step;
+        }
+    }
+    if (first == m_num_decls || get_entry(first).name != key) {
+        return nullptr;
+    }
+
+    auto decl = prepare(Prelude::decode(get_entry(first).decl));
+    if (! decl && ! m_source_name.empty() && ! m_rebuilt) {
+        // the file was damaged after it was written, make it again and look once more
+        m_rebuilt = true;
+        if (build()) {
+            return find(name);
+        }
+    }
+    m_decoded.emplace(name, decl);
+    return decl;
+}
@@ -0,0 +1,117 @@
+#ifndef KIRAZ_MODULEINTERFACE_H
+#define KIRAZ_MODULEINTERFACE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include <kiraz/Interner.h>
+#include <kiraz/MappedFile.h>
+#include <kiraz/Node.h>
+
+/**
+ * @brief ModuleInterface: Declarations a module exports, written next to its source as a .kzi
+ *        file the first time it is imported. Later imports map the file instead of parsing the
+ *        source, and only decode the declarations that are actually looked up.
+ *
+ *        Layout, all integers little endian:
+ *          "KZI" 1                      magic and version
+ *          u64 size, i64 mtime          stamp of the source the interface was made from
+ *          u32 count                    number of declarations
+ *          count x {u32 name offset, u32 name size, u32 decl offset, u32 decl size}, by name
+ *          names and declarations, the latter in the encoding of Prelude
+ */
+class ModuleInterface {
+public:
+    /* Identifies the version of a source file, a stale interface is rebuilt */
+    struct Stamp {
+        uint64_t size = 0;
+        int64_t mtime = 0;
+
+        bool operator==(const Stamp &) const = default;
+
+        /**
+         * @brief of: Returns the stamp of the given file.
+         * @return false if the file can not be inspected
+         */
+        static bool of(const std::string &file_name, Stamp &out);
+    };
+
+    /**
+     * @brief get_file_name: Returns the name of the interface of the given source file.
+     */
+    static std::string get_file_name(const std::string &source_name);
+
+    /**
+     * @brief write: Writes the declarations of a parsed module to the given file. Function bodies
+     *        are left out, so are the lets whose type can not be told without checking the module.
+     *        The file is replaced atomically, concurrent compilations see either version.
+     * @return false with errno set if the file could not be written
+     */
+    static bool write(const std::string &file_name, const Node::Ptr &module, const Stamp &stamp);
+
+    /**
+     * @brief open: Maps the given interface, provided it was made from the source with the
+     *        given stamp. Every index entry is checked against the size of the file.
+     * @return false if the file is missing, malformed or stale
+     */
+    bool open(const std::string &file_name, const Stamp &stamp);
+
+    /**
+     * @brief load: Maps the interface of the given source, parsing the source and writing the
+     *        interface first when it is missing, malformed or stale. Should a declaration fail to
+     *        decode later on, the interface is rebuilt the same way. When it can not be written,
+     *        eg. in a read only directory, the declarations of the parsed module are kept instead.
+     * @return false if the source can not be read or parsed
+     */
+    bool load(const std::string &source_name, const Stamp &stamp);
+
+    /**
+     * @brief find: Returns the declaration with the given name, decoding it on first use.
+     */
+    Node::Ptr find(Symbol name);
+
+    /**
+     * @brief for_each_name: Calls fn with the name of every declaration, without decoding any.
+     */
+    template <typename Fn>
+    void for_each_name(Fn &&fn) {
+        if (! m_num_decls) {
+            for (const auto &[name, decl] : m_decoded) {
+                fn(name.str());
+            }
+            return;
+        }
+        for (size_t i = 0; i < m_num_decls; ++i) {
+            fn(get_entry(i).name);
+        }
+    }
+
+    size_t size() const { return m_num_decls; }
+
+    /**
+     * @brief get_num_decoded: Number of declarations decoded so far.
+     */
+    size_t get_num_decoded() const { return m_decoded.size(); }
+
+private:
+    struct Entry {
+        std::string_view name;
+        std::string_view decl;
+    };
+
+    Entry get_entry(size_t index);
+    bool build();
+
+    MappedFile m_file;
+    size_t m_num_decls = 0;
+    std::unordered_map<Symbol, Node::Ptr> m_decoded;
+
+    /* Set by load(), a damaged interface is rebuilt from this source once */
+    std::string m_source_name;
+    Stamp m_stamp;
+    bool m_rebuilt = false;
+};
+
+#endif // KIRAZ_MODULEINTERFACE_H
@@ -5,11 +5,12 @@
 
 #include <kiraz/Compiler.h>
 
-int64_t Node::s_next_id;
-std::vector<Node::Ptr> Node::s_roots;
-Token::Ptr curtoken;
-
-Node::Node() : m_id(FF("Ki{}", ++s_next_id)) {}
+Node::Node() {
+    // nodes created outside of a compilation (eg. static builtins) are not counted
+    if (auto compiler = Compiler::current()) {
+        ++compiler->get_stats().num_nodes;
+    }
+}
 
 Node::~Node() {}
 
@@ -26,24 +27,46 @@ Node::Ptr Node::add_to_symtab_ordered(SymbolTable &st) {
     return nullptr;
 }
 
+std::vector<Node::Ptr> &Node::get_roots() {
+    assert(Compiler::current());
+    return Compiler::current()->get_parser_state().roots;
+}
+
+Arena *Node::get_arena() {
+    auto compiler = Compiler::current();
+    return compiler ? &compiler->get_arena() : nullptr;
+}
+
+void Node::set_current_root(const Ptr &root) {
+    auto &state = Compiler::current()->get_parser_state();
+    root->set_pos(yyget_lineno(state.scanner), state.colno);
+    state.roots.back() = root;
+}
+
+void Node::reset_root() {
+    auto &state = Compiler::current()->get_parser_state();
+    // only the latest root is looked at again, the older ones would pin their trees for as long
+    // as the compiler lives
+    if (state.roots.size() > 1) {
+        state.roots.erase(state.roots.begin(), std::prev(state.roots.end()));
+    }
+    state.roots.emplace_back();
+}
+
 Node::Ptr Node::pop_root() {
-    assert(! s_roots.empty());
-    auto retval = s_roots.back();
-    s_roots.pop_back();
+    auto &roots = get_roots();
+    assert(! roots.empty());
+    auto retval = roots.back();
+    roots.pop_back();
     return retval;
 }
 
 const Node::Ptr &Node::get_root_before() {
-    assert(s_roots.size() > 1);
-    return *std::next(s_roots.rbegin());
+    auto &roots = get_roots();
+    assert(roots.size() > 1);
+    return *std::next(roots.rbegin());
 }
 
-Node::Ptr Node::gen_wat(WasmContext &) {
-    assert(! m_id.empty());
-    return nullptr;
-}
-
-Node::Ptr Node::gen_wat(WasmContext &, const std::string &id) const {
-    assert(! id.empty());
-    return nullptr;
+Node::Ptr Node::gen_ir(ir::Builder &) {
+    return set_error(FF("Code generation is not supported for {}", as_string()));
 }
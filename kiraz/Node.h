@@ -9,13 +9,15 @@
 #define FF fmt::format
 #include <fmt/format.h>
 
+#include <kiraz/Arena.h>
 #include <kiraz/Token.h>
 
-extern int yylineno;
-
 class SymbolTable;
 struct Scope;
-class WasmContext;
+namespace ir {
+class Builder;
+}
+
 class Node : public std::enable_shared_from_this<Node> {
 public:
     using Ptr = std::shared_ptr<Node>;
@@ -32,22 +34,36 @@ public:
         m_col = c;
     }
 
+    /**
+     * @brief make: Allocates a node in the arena of the current Compiler, or on the heap when
+     *        there is none (eg. static builtins). Arena nodes must not be used after their
+     *        Compiler is destroyed: the memory goes away with it and destructors of nodes still
+     *        referenced, eg. through the node <-> Scope cycles, never run.
+     */
+    template <typename T, typename... Args>
+    static std::shared_ptr<T> make(Args &&...args) {
+        if (auto arena = get_arena()) {
+            return std::allocate_shared<T>(ArenaAllocator<T>(*arena), std::forward<Args>(args)...);
+        }
+        return std::make_shared<T>(std::forward<Args>(args)...);
+    }
+
     template <typename T, typename... Args>
     static auto add(Args &&...args) {
-        auto root = std::make_shared<T>(std::forward<Args>(args)...);
-        root->set_pos(yylineno, Token::colno);
-        s_roots.back() = root;
+        auto root = make<T>(std::forward<Args>(args)...);
+        set_current_root(root);
         return root;
     }
 
     template <typename T>
     static auto wrap(Node::Ptr node) {
-        return std::make_shared<T>(std::vector{node});
+        return make<T>(std::vector{node});
     }
 
     static auto &current_root() {
-        assert(! s_roots.empty());
-        return s_roots.back();
+        auto &roots = get_roots();
+        assert(! roots.empty());
+        return roots.back();
     }
 
     virtual bool is_func() const { return false; }
@@ -135,15 +151,12 @@ public:
     /*
      * Static interface
      */
-    static const Ptr &get_root() { return s_roots.back(); }
+    static const Ptr &get_root() { return get_roots().back(); }
     static Ptr pop_root();
     static const Ptr &get_root_before();
     static const Ptr &get_first();
     static const Ptr &get_first_before();
-    static void reset_root() {
-        s_roots.emplace_back();
-        s_next_id = 0;
-    }
+    static void reset_root();
     auto get_line() const { return m_line; }
     auto get_col() const { return m_col; }
     const auto &get_error() const { return m_error; }
@@ -167,29 +180,24 @@ public:
     auto get_cur_symtab() { return m_cur_symtab; }
     auto get_cur_symtab() const { return m_cur_symtab; }
 
-    virtual Node::Ptr gen_wat(WasmContext &);
-    virtual Node::Ptr gen_wat(WasmContext &, const std::string &id) const;
-
-    const auto &get_id() const {
-        assert(! m_id.empty());
-        return m_id;
-    }
-
-    void set_id(const std::string &v) {
-        assert(! v.empty());
-        m_id = v;
-    }
+    /**
+     * @brief gen_ir: Lowers this statement into the function being built.
+     * @return: Returns nullptr if no errors are found. Otherwise sets the error
+     *          string on the statement that caused the error and returns it.
+     */
+    virtual Node::Ptr gen_ir(ir::Builder &);
 
 protected:
     std::shared_ptr<Scope> m_cur_symtab;
 
 private:
-    static std::vector<Node::Ptr> s_roots;
+    /* Root stack of the Compiler active on the calling thread */
+    static std::vector<Node::Ptr> &get_roots();
+    static void set_current_root(const Ptr &root);
+    static Arena *get_arena();
 
     Cptr m_type;
 
-    static int64_t s_next_id;
-    std::string m_id;
     std::string m_error;
     int m_line = 0;
     int m_col = 0;
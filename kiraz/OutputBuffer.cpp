@@ -0,0 +1,103 @@
+
+#include "OutputBuffer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+OutputBuffer &OutputBuffer::operator=(OutputBuffer &&other) noexcept {
+    if (this != &other) {
+        clear();
+        std::swap(m_head, other.m_head);
+        std::swap(m_tail, other.m_tail);
+        std::swap(m_size, other.m_size);
+    }
+    return *this;
+}
+
+void OutputBuffer::add_chunk(size_t min_capacity) {
+    // chunks grow with the buffer, so small buffers stay small and large ones need few chunks
+    auto capacity = std::clamp(m_size, MIN_CHUNK_SIZE, MAX_CHUNK_SIZE);
+    capacity = std::max(capacity, min_capacity);
+
+    auto chunk = new (::operator new(sizeof(Chunk) + capacity)) Chunk;
+    chunk->capacity = capacity;
+
+    if (m_tail) {
+        m_tail->next = chunk;
+    }
+    else {
+        m_head = chunk;
+    }
+    m_tail = chunk;
+}
+
+void OutputBuffer::append(std::string_view text) {
+    // fill up the current chunk, the rest goes into a fresh one that fits it whole
+    if (m_tail) {
+        auto length = std::min(m_tail->capacity - m_tail->used, text.size());
+        std::memcpy(m_tail->data() + m_tail->used, text.data(), length);
+        m_tail->used += length;
+        m_size += length;
+        text.remove_prefix(length);
+    }
+
+    if (text.empty()) {
+        return;
+    }
+
+    add_chunk(text.size());
+    std::memcpy(m_tail->data(), text.data(), text.size());
+    m_tail->used = text.size();
+    m_size += text.size();
+}
+
+void OutputBuffer::splice(OutputBuffer &other) {
+    if (this == &other || ! other.m_head) {
+        return;
+    }
+
+    if (m_tail) {
+        m_tail->next = other.m_head;
+    }
+    else {
+        m_head = other.m_head;
+    }
+    m_tail = other.m_tail;
+    m_size += other.m_size;
+
+    other.m_head = other.m_tail = nullptr;
+    other.m_size = 0;
+}
+
+void OutputBuffer::clear() {
+    auto chunk = m_head;
+    while (chunk) {
+        auto next = chunk->next;
+        chunk->~Chunk();
+        ::operator delete(chunk);
+        chunk = next;
+    }
+
+    m_head = m_tail = nullptr;
+    m_size = 0;
+}
+
+std::string OutputBuffer::str() const {
+    std::string retval;
+    retval.reserve(m_size);
+    for_each_chunk([&retval](std::string_view text) { retval.append(text); });
+    return retval;
+}
+
+void OutputBuffer::write_to(std::ostream &os) const {
+    for_each_chunk([&os](std::string_view text) { os.write(text.data(), text.size()); });
+}
+
+bool OutputBuffer::write_to(std::FILE *file) const {
+    bool ok = true;
+    for_each_chunk([&ok, file](std::string_view text) {
+        ok = ok && std::fwrite(text.data(), 1, text.size(), file) == text.size();
+    });
+    return ok;
+}
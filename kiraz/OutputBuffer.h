@@ -0,0 +1,108 @@
+#ifndef KIRAZ_OUTPUTBUFFER_H
+#define KIRAZ_OUTPUTBUFFER_H
+
+#include <charconv>
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include <kiraz/Interner.h>
+
+/**
+ * @brief OutputBuffer: Append-only text buffer made of a linked list of chunks. Appending copies
+ *        the text once into the last chunk, splicing another buffer in only relinks its chunks,
+ *        so nested output is never copied on its way up. The text is copied a second time only
+ *        when it is finally written to its sink.
+ */
+class OutputBuffer {
+public:
+    OutputBuffer() = default;
+    OutputBuffer(const OutputBuffer &) = delete;
+    OutputBuffer &operator=(const OutputBuffer &) = delete;
+    OutputBuffer(OutputBuffer &&other) noexcept { *this = std::move(other); }
+    OutputBuffer &operator=(OutputBuffer &&other) noexcept;
+    ~OutputBuffer() { clear(); }
+
+    void append(std::string_view text);
+
+    /**
+     * @brief splice: Moves the contents of the other buffer to the end of this one in O(1),
+     *        leaving the other buffer empty.
+     */
+    void splice(OutputBuffer &other);
+
+    void clear();
+
+    auto size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    /**
+     * @brief for_each_chunk: Calls f with a string_view of every chunk, in order.
+     */
+    template <typename F>
+    void for_each_chunk(F &&f) const {
+        for (auto chunk = m_head; chunk; chunk = chunk->next) {
+            if (chunk->used) {
+                f(std::string_view(chunk->data(), chunk->used));
+            }
+        }
+    }
+
+    std::string str() const;
+    void write_to(std::ostream &os) const;
+
+    /**
+     * @brief write_to: Writes the contents to the given stream.
+     * @return false if not everything could be written
+     */
+    bool write_to(std::FILE *file) const;
+
+    OutputBuffer &operator<<(std::string_view text) {
+        append(text);
+        return *this;
+    }
+    OutputBuffer &operator<<(const char *text) { return *this << std::string_view(text); }
+    OutputBuffer &operator<<(const std::string &text) { return *this << std::string_view(text); }
+    OutputBuffer &operator<<(Symbol symbol) { return *this << std::string_view(symbol.str()); }
+    OutputBuffer &operator<<(char c) { return *this << std::string_view(&c, 1); }
+
+    /* would otherwise print as a number or convert to char, spell out what is meant instead */
+    OutputBuffer &operator<<(bool) = delete;
+
+    template <typename T>
+        requires(std::is_integral_v<T> && ! std::is_same_v<T, bool>)
+    OutputBuffer &operator<<(T value) {
+        char text[24];
+        auto result = std::to_chars(std::begin(text), std::end(text), value);
+        return *this << std::string_view(text, result.ptr - text);
+    }
+
+private:
+    static constexpr size_t MIN_CHUNK_SIZE = 256;
+    static constexpr size_t MAX_CHUNK_SIZE = 64 * 1024;
+
+    /* Header of a chunk, the text follows it in the same allocation */
+    struct Chunk {
+        Chunk *next = nullptr;
+        size_t capacity = 0;
+        size_t used = 0;
+
+        char *data() { return reinterpret_cast<char *>(this + 1); }
+        const char *data() const { return reinterpret_cast<const char *>(this + 1); }
+    };
+
+    void add_chunk(size_t min_capacity);
+
+    Chunk *m_head = nullptr;
+    Chunk *m_tail = nullptr;
+    size_t m_size = 0;
+};
+
+inline std::ostream &operator<<(std::ostream &os, const OutputBuffer &buffer) {
+    buffer.write_to(os);
+    return os;
+}
+
+#endif // KIRAZ_OUTPUTBUFFER_H
@@ -0,0 +1,68 @@
+#ifndef KIRAZ_PARSERSTATE_H
+#define KIRAZ_PARSERSTATE_H
+
+#include <charconv>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <kiraz/CompileStats.h>
+#include <kiraz/Interner.h>
+#include <kiraz/Token.h>
+
+class Node;
+
+namespace ast {
+class Parameter;
+class ParameterList;
+}
+
+/**
+ * @brief ParserState: Lexer and parser state of a single Compiler instance. The reentrant scanner
+ *        reaches it through yyextra, grammar actions and Node through Compiler::current().
+ */
+struct ParserState {
+    yyscan_t scanner = nullptr;
+
+    Lexeme token;
+    Interner names;
+    int colno = 0;
+
+    /* Statistics of the owning Compiler */
+    CompileStats *stats = nullptr;
+
+    std::vector<std::shared_ptr<Node>> roots;
+
+    std::shared_ptr<ast::ParameterList> parameters;
+    std::vector<std::shared_ptr<ast::Parameter>> param_vector;
+
+    /**
+     * @brief scanned: Records the token the scanner just matched and returns its kind.
+     */
+    int scanned(int kind, const char *text, int length, int line) {
+        if (stats) {
+            ++stats->num_tokens;
+        }
+        colno += length;
+        token = {kind, line, colno, {text, size_t(length)}, 0, {}};
+        return kind;
+    }
+
+    int scanned_integer(const char *text, int length, int line) {
+        scanned(L_INTEGER, text, length, line);
+        auto [end, ec] = std::from_chars(text, text + length, token.integer);
+        if (ec != std::errc()) {
+            // out of range
+            token.integer = 0;
+        }
+        return L_INTEGER;
+    }
+
+    int scanned_identifier(const char *text, int length, int line) {
+        scanned(IDENTIFIER, text, length, line);
+        token.name = names.intern(token.text);
+        return IDENTIFIER;
+    }
+};
+
+#endif // KIRAZ_PARSERSTATE_H
@@ -0,0 +1,379 @@
+
+#include "Prelude.h"
+
+#include <algorithm>
+#include <initializer_list>
+
+#include <kiraz/Compiler.h>
+#include <kiraz/WasmWriter.h>
+#include <kiraz/ast/Boolean.h>
+#include <kiraz/ast/Identifier.h>
+#include <kiraz/ast/Literal.h>
+#include <kiraz/ast/Statement.h>
+
+#ifndef KIRAZ_PRELUDE_BOOTSTRAP
+#include <resource/PRELUDE_io.h>
+#endif
+
+namespace {
+
+/* Every node starts with its tag, all but Null continue with the line and the column */
+enum class Tag : uint8_t {
+    Null,
+    Module,
+    StatementList,
+    Class,
+    Function,
+    ParameterList,
+    Parameter,
+    Let,
+    Identifier,
+    BuiltinType,
+    Integer,
+    Boolean,
+};
+
+using Bytes = Prelude::Bytes;
+
+void write_text(Bytes &out, std::string_view text) {
+    WasmWriter::write_uleb(out, text.size());
+    out.insert(out.end(), text.begin(), text.end());
+}
+
+Node::Ptr write_node(Bytes &out, const Node::Ptr &node);
+
+Node::Ptr write_nodes(Bytes &out, const std::vector<Node::Ptr> &nodes) {
+    WasmWriter::write_uleb(out, nodes.size());
+    for (const auto &node : nodes) {
+        if (auto ret = write_node(out, node)) {
+            return ret;
+        }
+    }
+    return nullptr;
+}
+
+Node::Ptr write_node(Bytes &out, const Node::Ptr &node) {
+    if (! node) {
+        out.push_back(uint8_t(Tag::Null));
+        return nullptr;
+    }
+
+    auto write_head = [&](Tag tag) {
+        out.push_back(uint8_t(tag));
+        WasmWriter::write_uleb(out, node->get_line());
+        WasmWriter::write_uleb(out, node->get_col());
+    };
+
+    if (auto module = std::dynamic_pointer_cast<ast::Module>(node)) {
+        write_head(Tag::Module);
+        return write_node(out, module->get_statements());
+    }
+    if (auto list = std::dynamic_pointer_cast<ast::StatementList>(node)) {
+        write_head(Tag::StatementList);
+        return write_nodes(out, list->get_statements());
+    }
+    if (auto cls = std::dynamic_pointer_cast<ast::ClassStatement>(node)) {
+        write_head(Tag::Class);
+        for (const auto &child : {cls->get_name(), cls->get_stmts(), cls->get_parent_class()}) {
+            if (auto ret = write_node(out, child)) {
+                return ret;
+            }
+        }
+        return nullptr;
+    }
+    if (auto func = std::dynamic_pointer_cast<ast::FunctionStatement>(node)) {
+        write_head(Tag::Function);
+        for (const auto &child : {func->get_name(), func->get_parameters(),
+                     func->get_return_type(), func->get_body()}) {
+            if (auto ret = write_node(out, child)) {
+                return ret;
+            }
+        }
+        return nullptr;
+    }
+    if (auto params = std::dynamic_pointer_cast<ast::ParameterList>(node)) {
+        write_head(Tag::ParameterList);
+        return write_nodes(out, params->get_parameters());
+    }
+    if (auto param = std::dynamic_pointer_cast<ast::Parameter>(node)) {
+        write_head(Tag::Parameter);
+        if (auto ret = write_node(out, param->get_name())) {
+            return ret;
+        }
+        return write_node(out, param->get_type());
+    }
+    if (auto let = std::dynamic_pointer_cast<ast::LetStatement>(node)) {
+        write_head(Tag::Let);
+        for (const auto &child : {let->get_identifier(), let->get_type(), let->get_value()}) {
+            if (auto ret = write_node(out, child)) {
+                return ret;
+            }
+        }
+        return nullptr;
+    }
+    if (auto id = std::dynamic_pointer_cast<ast::Identifier>(node)) {
+        write_head(Tag::Identifier);
+        write_text(out, id->get_name().str());
+        return nullptr;
+    }
+    if (auto type = std::dynamic_pointer_cast<ast::BuiltinType>(node)) {
+        write_head(Tag::BuiltinType);
+        write_text(out, type->get_name());
+        return nullptr;
+    }
+    if (auto integer = std::dynamic_pointer_cast<ast::Integer>(node)) {
+        write_head(Tag::Integer);
+        WasmWriter::write_sleb(out, integer->get_value());
+        return nullptr;
+    }
+    if (auto boolean = std::dynamic_pointer_cast<ast::Boolean>(node)) {
+        write_head(Tag::Boolean);
+        out.push_back(boolean->get_value());
+        return nullptr;
+    }
+
+    return node;
+}
+
+/*
+ * Reads back what write_node wrote. Interfaces come from disk, so every read is checked: a
+ * truncated or garbled input makes the reader fail, not crash, and decode() returns nullptr.
+ */
+class Reader {
+public:
+    /* Nested classes are the only recursion, real modules stay far below this */
+    static constexpr size_t MAX_DEPTH = 64;
+
+    explicit Reader(std::string_view data) : m_data(data) {}
+
+    bool at_end() const { return m_pos == m_data.size(); }
+    bool is_failed() const { return m_failed; }
+
+    uint64_t read_uleb() {
+        uint64_t retval = 0;
+        for (unsigned shift = 0;; shift += 7) {
+            auto byte = read_byte();
+            if (shift >= 64) {
+                fail();
+                return 0;
+            }
+            retval |= uint64_t(byte & 0x7f) << shift;
+            if (! (byte & 0x80)) {
+                return retval;
+            }
+        }
+    }
+
+    int64_t read_sleb() {
+        int64_t retval = 0;
+        unsigned shift = 0;
+        uint8_t byte;
+        do {
+            byte = read_byte();
+            if (shift >= 64) {
+                fail();
+                return 0;
+            }
+            retval |= int64_t(byte & 0x7f) << shift;
+            shift += 7;
+        } while (byte & 0x80);
+
+        if (shift < 64 && (byte & 0x40)) {
+            retval |= -(int64_t(1) << shift);
+        }
+        return retval;
+    }
+
+    std::string_view read_text() {
+        auto size = read_uleb();
+        if (size > m_data.size() - m_pos) {
+            fail();
+            return {};
+        }
+        auto retval = m_data.substr(m_pos, size);
+        m_pos += size;
+        return retval;
+    }
+
+    /**
+     * @brief read_node: Reads a node with one of the given tags, Null among them if the node is
+     *        optional. Any other tag fails the reader.
+     */
+    Node::Ptr read_node(std::initializer_list<Tag> tags) {
+        auto tag = Tag(read_byte());
+        if (std::find(tags.begin(), tags.end(), tag) == tags.end()) {
+            fail();
+            return nullptr;
+        }
+        if (tag == Tag::Null || m_failed) {
+            return nullptr;
+        }
+        if (m_depth == MAX_DEPTH) {
+            fail();
+            return nullptr;
+        }
+
+        int line = read_uleb();
+        int col = read_uleb();
+        ++m_depth;
+        auto retval = read_payload(tag);
+        --m_depth;
+        if (! retval || m_failed) {
+            fail();
+            return nullptr;
+        }
+        if (tag != Tag::BuiltinType) { // builtin types are shared by all compilations
+            retval->set_pos(line, col);
+        }
+        return retval;
+    }
+
+private:
+    void fail() {
+        m_failed = true;
+        m_pos = m_data.size();
+    }
+
+    uint8_t read_byte() {
+        if (m_pos == m_data.size()) {
+            fail();
+            return 0;
+        }
+        return m_data[m_pos++];
+    }
+
+    /* Reads the size of a list, every item takes at least a byte */
+    uint64_t read_size() {
+        auto size = read_uleb();
+        if (size == 0 || size > m_data.size() - m_pos) {
+            fail();
+            return 0;
+        }
+        return size;
+    }
+
+    Node::Ptr read_payload(Tag tag) {
+        static constexpr std::initializer_list<Tag> DECLS = {Tag::Class, Tag::Function, Tag::Let};
+        static constexpr std::initializer_list<Tag> TYPES = {Tag::Identifier, Tag::BuiltinType};
+
+        switch (tag) {
+        case Tag::Module:
+            return Node::make<ast::Module>(read_node({Tag::StatementList, Tag::Null}));
+
+        case Tag::StatementList: {
+            auto size = read_size();
+            if (! size) {
+                return nullptr;
+            }
+            auto retval = Node::make<ast::StatementList>(read_node(DECLS));
+            for (uint64_t i = 1; i < size && ! m_failed; ++i) {
+                retval->append(read_node(DECLS));
+            }
+            return retval;
+        }
+
+        case Tag::Class: {
+            auto name = read_node({Tag::Identifier});
+            auto stmts = read_node({Tag::StatementList, Tag::Null});
+            auto parent = read_node({Tag::Identifier, Tag::Null});
+            return Node::make<ast::ClassStatement>(name, stmts, parent);
+        }
+
+        case Tag::Function: {
+            auto name = read_node({Tag::Identifier});
+            auto params = read_node({Tag::ParameterList, Tag::Null});
+            auto return_type = read_node({Tag::Identifier, Tag::BuiltinType, Tag::Null});
+            auto body = read_node({Tag::Null});
+            auto retval = Node::make<ast::FunctionStatement>(name, params, return_type, body);
+
+            // the parser links the parameters back to their function, so does the prelude
+            if (auto list = std::dynamic_pointer_cast<ast::ParameterList>(params)) {
+                list->set_stmt(retval);
+                for (const auto &param : list->get_parameters()) {
+                    std::static_pointer_cast<ast::Parameter>(param)->set_stmt(retval);
+                }
+            }
+            return retval;
+        }
+
+        case Tag::ParameterList: {
+            auto size = read_size();
+            if (! size) {
+                return nullptr;
+            }
+            auto retval = Node::make<ast::ParameterList>(read_node({Tag::Parameter}));
+            for (uint64_t i = 1; i < size && ! m_failed; ++i) {
+                retval->append(read_node({Tag::Parameter}));
+            }
+            return retval;
+        }
+
+        case Tag::Parameter: {
+            auto name = read_node({Tag::Identifier});
+            auto type = read_node(TYPES);
+            return Node::make<ast::Parameter>(name, type);
+        }
+
+        case Tag::Let: {
+            auto identifier = read_node({Tag::Identifier});
+            auto type = read_node({Tag::Identifier, Tag::BuiltinType, Tag::Null});
+            auto value = read_node({Tag::Integer, Tag::Boolean, Tag::Null});
+            if (! type) {
+                return Node::make<ast::LetStatement>(identifier, value);
+            }
+            return Node::make<ast::LetStatement>(identifier, type, value);
+        }
+
+        case Tag::Identifier: {
+            auto name = read_text();
+            if (name.empty()) {
+                return nullptr;
+            }
+            return Node::make<ast::Identifier>(SymbolTable::get_names().intern(name));
+        }
+
+        case Tag::BuiltinType:
+            return ast::BuiltinManager::get_builtin_type(std::string(read_text()));
+
+        case Tag::Integer:
+            return Node::make<ast::Integer>(read_sleb());
+
+        case Tag::Boolean:
+            return Node::make<ast::Boolean>(read_byte() != 0);
+
+        case Tag::Null:
+            break;
+        }
+
+        return nullptr;
+    }
+
+    std::string_view m_data;
+    size_t m_pos = 0;
+    size_t m_depth = 0;
+    bool m_failed = false;
+};
+
+} // namespace
+
+Node::Ptr Prelude::encode(const Node::Ptr &node, Bytes &out) {
+    return write_node(out, node);
+}
+
+Node::Ptr Prelude::decode(std::string_view data) {
+    Reader reader(data);
+    auto retval = reader.read_node({Tag::Module, Tag::StatementList, Tag::Class, Tag::Function,
+            Tag::Let});
+    if (reader.is_failed() || ! reader.at_end()) {
+        return nullptr;
+    }
+    return retval;
+}
+
+Node::Ptr Prelude::load_io() {
+#ifdef KIRAZ_PRELUDE_BOOTSTRAP
+    return nullptr;
+#else
+    return decode({reinterpret_cast<const char *>(PRELUDE_io), sizeof(PRELUDE_io)});
+#endif
+}
@@ -0,0 +1,40 @@
+#ifndef KIRAZ_PRELUDE_H
+#define KIRAZ_PRELUDE_H
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include <kiraz/Node.h>
+
+/**
+ * @brief Prelude: Compact serialized form of the declarations in io.ki. The kiraz_prelude tool
+ *        parses io.ki once at build time and writes the encoded tree into a generated header,
+ *        compilations rebuild the nodes from those bytes instead of scanning and parsing the text.
+ */
+class Prelude {
+public:
+    using Bytes = std::vector<uint8_t>;
+
+    /**
+     * @brief encode: Appends the serialized form of the given module or declaration to out. Only
+     *        declarations are supported: classes, functions with their parameters and lets with
+     *        literal values.
+     * @return The first node that can not be encoded, nullptr on success
+     */
+    static Node::Ptr encode(const Node::Ptr &node, Bytes &out);
+
+    /**
+     * @brief decode: Rebuilds the encoded nodes in the arena of the current compiler.
+     * @return nullptr if the data is truncated or malformed
+     */
+    static Node::Ptr decode(std::string_view data);
+
+    /**
+     * @brief load_io: Returns a fresh copy of the io module, nullptr when the build did not embed
+     *        it (ie. in kiraz_prelude itself).
+     */
+    static Node::Ptr load_io();
+};
+
+#endif // KIRAZ_PRELUDE_H
@@ -1,5 +1,53 @@
 
 #include "Token.h"
 
-int Token::colno;
+#include <kiraz/token/Boolean.h>
+#include <kiraz/token/Identifier.h>
+#include <kiraz/token/Keyword.h>
+#include <kiraz/token/Literal.h>
+#include <kiraz/token/Operator.h>
+
 Token::~Token() {}
+
+Token::Ptr Token::from_lexeme(const Lexeme &lexeme) {
+    using namespace token;
+
+    switch (lexeme.kind) {
+    case KW_IMPORT: return New<KeywordImport>();
+    case KW_FUNC: return New<KeywordFunc>();
+    case KW_RETURN: return New<KeywordReturn>();
+    case KW_IF: return New<KeywordIf>();
+    case KW_ELSE: return New<KeywordElse>();
+    case KW_WHILE: return New<KeywordWhile>();
+    case KW_LET: return New<KeywordLet>();
+    case KW_CLASS: return New<KeywordClass>();
+    case L_TRUE: return New<Boolean>(true);
+    case L_FALSE: return New<Boolean>(false);
+    case L_INTEGER: return New<Integer>(10, lexeme.text);
+    case L_STRING: return New<String>(lexeme.text);
+    case IDENTIFIER: return New<Identifier>(lexeme.name);
+    case OP_AND: return New<OpAnd>();
+    case OP_OR: return New<OpOr>();
+    case OP_NOT: return New<OpNot>();
+    case OP_RETURNS: return New<OpReturns>();
+    case OP_EQUALS: return New<OpEquals>();
+    case OP_ASSIGN: return New<OpAssign>();
+    case OP_GT: return New<OpGt>();
+    case OP_LT: return New<OpLt>();
+    case OP_GE: return New<OpGe>();
+    case OP_LE: return New<OpLe>();
+    case OP_LPAREN: return New<OpLparen>();
+    case OP_RPAREN: return New<OpRparen>();
+    case OP_LBRACE: return New<OpLbrace>();
+    case OP_RBRACE: return New<OpRbrace>();
+    case OP_PLUS: return New<OpPlus>();
+    case OP_MINUS: return New<OpMinus>();
+    case OP_MULT: return New<OpMult>();
+    case OP_DIVF: return New<OpDivF>();
+    case OP_COMMA: return New<OpComma>();
+    case OP_COLON: return New<OpColon>();
+    case OP_SCOLON: return New<OpScolon>();
+    case OP_DOT: return New<OpDot>();
+    default: return New<Rejected>(lexeme.text);
+    }
+}
@@ -1,7 +1,29 @@
 #ifndef KIRAZ_TOKEN_H
 #define KIRAZ_TOKEN_H
 
+#include <cstdint>
+#include <string_view>
+
 #include "main.h"
+#include <kiraz/Interner.h>
+
+/**
+ * @brief Lexeme: Plain description of the token the scanner matched last. The scanner fills it in
+ *        place, so scanning allocates nothing. The text points into the scanner buffer and is
+ *        only valid until the next token is scanned.
+ */
+struct Lexeme {
+    int kind = 0;
+    int line = 0;
+    int col = 0;
+    std::string_view text;
+
+    /* Value of L_INTEGER, already parsed */
+    int64_t integer = 0;
+
+    /* Interned name of IDENTIFIER */
+    Symbol name;
+};
 
 class Token {
 public:
@@ -24,17 +46,20 @@ public:
         return std::make_shared<T>(std::forward<Args>(args)...);
     }
 
-    static int colno;
-
     virtual int get_id() const { return m_id; }
 
+    /**
+     * @brief from_lexeme: Builds the token object for a scanned lexeme, eg. for diagnostics.
+     */
+    static Ptr from_lexeme(const Lexeme &lexeme);
+
 private:
     int m_id;
 };
 
 class Rejected : public Token {
 public:
-    Rejected(const char *text) : Token(YYUNDEF), m_text(text) {}
+    Rejected(std::string_view text) : Token(YYUNDEF), m_text(text) {}
     std::string as_string() const override { return fmt::format("REJECTED({})", m_text); }
 
 private:
@@ -0,0 +1,177 @@
+#include "Trace.h"
+
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <fmt/format.h>
+
+std::atomic<bool> Trace::s_enabled = false;
+
+namespace {
+
+struct Event {
+    const char *name;
+    std::string detail;
+    int64_t begin;
+    int64_t duration;
+};
+
+struct Buffer {
+    /* Only contended while the trace is written or cleared */
+    std::mutex mutex;
+    uint32_t tid = 0;
+    std::vector<Event> events;
+    size_t num_dropped = 0;
+};
+
+/* Buffers of every thread that recorded, they outlive their threads until written out */
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<Buffer>> buffers;
+    Trace::Clock::time_point epoch;
+};
+
+Registry &get_registry() {
+    static Registry registry;
+    return registry;
+}
+
+Buffer &get_buffer() {
+    thread_local std::shared_ptr<Buffer> buffer;
+    if (! buffer) {
+        buffer = std::make_shared<Buffer>();
+        auto &registry = get_registry();
+        std::lock_guard lock(registry.mutex);
+        buffer->tid = registry.buffers.size() + 1;
+        registry.buffers.push_back(buffer);
+    }
+    return *buffer;
+}
+
+int64_t to_ns(Trace::Clock::duration duration) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+}
+
+void append_escaped(std::string &out, std::string_view text) {
+    for (auto c : text) {
+        switch (c) {
+        case '"':
+            out += "\\\"";
+            break;
+        case '\\':
+            out += "\\\\";
+            break;
+        default:
+            if (uint8_t(c) < 0x20) {
+                out += fmt::format("\\u{:04x}", int(c));
+            }
+            else {
+                out += c;
+            }
+        }
+    }
+}
+
+} // namespace
+
+void Trace::start() {
+    auto &registry = get_registry();
+    {
+        std::lock_guard lock(registry.mutex);
+        if (registry.epoch == Clock::time_point{}) {
+            registry.epoch = Clock::now();
+        }
+    }
+    s_enabled.store(true, std::memory_order_relaxed);
+}
+
+void Trace::stop() {
+    s_enabled.store(false, std::memory_order_relaxed);
+}
+
+void Trace::record(const char *name, std::string_view detail, Clock::time_point begin,
+        Clock::time_point end) {
+    auto &buffer = get_buffer();
+    std::lock_guard lock(buffer.mutex);
+    if (buffer.events.size() >= MAX_EVENTS_PER_THREAD) {
+        ++buffer.num_dropped;
+        return;
+    }
+    buffer.events.push_back(
+            {name, std::string(detail), to_ns(begin.time_since_epoch()), to_ns(end - begin)});
+}
+
+bool Trace::write(const std::string &file_name) {
+    auto &registry = get_registry();
+    std::lock_guard lock(registry.mutex);
+    auto epoch = to_ns(registry.epoch.time_since_epoch());
+
+    std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    auto separate = [&out, &first] {
+        if (! first) {
+            out += ",\n";
+        }
+        first = false;
+    };
+
+    for (const auto &buffer : registry.buffers) {
+        std::lock_guard buffer_lock(buffer->mutex);
+        separate();
+        out += fmt::format("{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},"
+                           "\"args\":{{\"name\":\"{}\"}}}}",
+                buffer->tid, fmt::format("thread {}", buffer->tid));
+
+        // timestamps are in microseconds, fractions keep the nanoseconds
+        for (const auto &event : buffer->events) {
+            separate();
+            out += fmt::format("{{\"name\":\"{}\",\"cat\":\"kiraz\",\"ph\":\"X\",\"pid\":1,"
+                               "\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}",
+                    event.name, buffer->tid, (event.begin - epoch) / 1e3, event.duration / 1e3);
+            if (! event.detail.empty()) {
+                out += ",\"args\":{\"detail\":\"";
+                append_escaped(out, event.detail);
+                out += "\"}";
+            }
+            out += "}";
+        }
+
+        if (buffer->num_dropped) {
+            separate();
+            out += fmt::format("{{\"name\":\"dropped {} events\",\"ph\":\"i\",\"s\":\"t\","
+                               "\"pid\":1,\"tid\":{},\"ts\":0}}",
+                    buffer->num_dropped, buffer->tid);
+        }
+    }
+    out += "]}\n";
+
+    auto file = std::fopen(file_name.data(), "wb");
+    if (! file) {
+        return false;
+    }
+    bool ok = std::fwrite(out.data(), 1, out.size(), file) == out.size();
+    return std::fclose(file) == 0 && ok;
+}
+
+void Trace::clear() {
+    auto &registry = get_registry();
+    std::lock_guard lock(registry.mutex);
+    for (auto &buffer : registry.buffers) {
+        std::lock_guard buffer_lock(buffer->mutex);
+        buffer->events.clear();
+        buffer->num_dropped = 0;
+    }
+}
+
+size_t Trace::get_num_events() {
+    auto &registry = get_registry();
+    std::lock_guard lock(registry.mutex);
+    size_t retval = 0;
+    for (const auto &buffer : registry.buffers) {
+        std::lock_guard buffer_lock(buffer->mutex);
+        retval += buffer->events.size();
+    }
+    return retval;
+}
@@ -0,0 +1,85 @@
+#ifndef KIRAZ_TRACE_H
+#define KIRAZ_TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Trace: Records timed spans in the Chrome trace event format, viewable in Perfetto or
+ *        chrome://tracing. Every thread appends to a buffer of its own under a lock that only
+ *        write(), clear() and get_num_events() contend for, and a span costs a single relaxed
+ *        load while recording is off.
+ */
+class Trace {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /* Spans a thread records beyond this are dropped, and counted */
+    static constexpr size_t MAX_EVENTS_PER_THREAD = size_t(1) << 20;
+
+    /**
+     * @brief Span: Records the lifetime of the object as one event of the calling thread. The
+     *        name must outlive the trace, the detail only has to outlive the span.
+     */
+    class Span {
+    public:
+        explicit Span(const char *name, std::string_view detail = {})
+                : m_name(is_enabled() ? name : nullptr), m_detail(detail) {
+            if (m_name) {
+                m_begin = Clock::now();
+            }
+        }
+        Span(const Span &) = delete;
+        Span &operator=(const Span &) = delete;
+        ~Span() {
+            if (m_name) {
+                record(m_name, m_detail, m_begin, Clock::now());
+            }
+        }
+
+    private:
+        const char *m_name;
+        std::string_view m_detail;
+        Clock::time_point m_begin;
+    };
+
+    static bool is_enabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief start: Turns recording on for all threads.
+     */
+    static void start();
+
+    /**
+     * @brief stop: Turns recording off, the recorded events are kept.
+     */
+    static void stop();
+
+    /**
+     * @brief write: Writes the events of all threads to the given file as JSON. Threads may keep
+     *        recording meanwhile, their new events may or may not make it into the file.
+     * @return false with errno set if the file could not be written
+     */
+    static bool write(const std::string &file_name);
+
+    /**
+     * @brief clear: Discards the events recorded so far.
+     */
+    static void clear();
+
+    /**
+     * @brief get_num_events: Returns the number of events recorded so far on all threads.
+     */
+    static size_t get_num_events();
+
+private:
+    static void record(const char *name, std::string_view detail, Clock::time_point begin,
+            Clock::time_point end);
+
+    static std::atomic<bool> s_enabled;
+};
+
+#endif // KIRAZ_TRACE_H
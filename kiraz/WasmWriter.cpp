@@ -0,0 +1,253 @@
+
+#include "WasmWriter.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace {
+constexpr uint8_t SECTION_TYPE = 1;
+constexpr uint8_t SECTION_FUNCTION = 3;
+constexpr uint8_t SECTION_GLOBAL = 6;
+constexpr uint8_t SECTION_EXPORT = 7;
+constexpr uint8_t SECTION_CODE = 10;
+
+constexpr uint8_t TYPE_FUNC = 0x60;
+constexpr uint8_t TYPE_I32 = 0x7f;
+constexpr uint8_t TYPE_I64 = 0x7e;
+constexpr uint8_t EMPTY_BLOCK = 0x40;
+constexpr uint8_t EXPORT_FUNC = 0x00;
+constexpr uint8_t GLOBAL_MUTABLE = 0x01;
+
+constexpr uint8_t OP_END = 0x0b;
+
+uint8_t get_value_type(ir::Type type) {
+    assert(type != ir::Type::Void);
+    return type == ir::Type::I32 ? TYPE_I32 : TYPE_I64;
+}
+
+/* Picks the i32 or the i64 variant of a numeric opcode */
+uint8_t typed(ir::Type type, uint8_t op_i32, uint8_t op_i64) {
+    assert(type != ir::Type::Void);
+    return type == ir::Type::I32 ? op_i32 : op_i64;
+}
+} // namespace
+
+void WasmWriter::write_uleb(Bytes &out, uint64_t value) {
+    do {
+        uint8_t byte = value & 0x7f;
+        value >>= 7;
+        out.push_back(value ? byte | 0x80 : byte);
+    } while (value);
+}
+
+void WasmWriter::write_sleb(Bytes &out, int64_t value) {
+    for (;;) {
+        uint8_t byte = value & 0x7f;
+        value >>= 7; // arithmetic shift, the sign bit is replicated
+
+        // done once the remaining bits are all copies of the sign bit of this byte
+        if ((value == 0 && ! (byte & 0x40)) || (value == -1 && (byte & 0x40))) {
+            out.push_back(byte);
+            return;
+        }
+        out.push_back(byte | 0x80);
+    }
+}
+
+void WasmWriter::write_name(Bytes &out, std::string_view name) {
+    write_uleb(out, name.size());
+    out.insert(out.end(), name.begin(), name.end());
+}
+
+void WasmWriter::write_section(Bytes &out, uint8_t id, const Bytes &contents) {
+    out.push_back(id);
+    write_uleb(out, contents.size());
+    out.insert(out.end(), contents.begin(), contents.end());
+}
+
+void WasmWriter::write_instr(Bytes &out, const ir::Instr &instr) {
+    using ir::Opcode;
+
+    switch (instr.op) {
+    case Opcode::Unreachable:
+        out.push_back(0x00);
+        break;
+    case Opcode::Block:
+    case Opcode::Loop:
+    case Opcode::If:
+        out.push_back(instr.op == Opcode::Block ? 0x02 : instr.op == Opcode::Loop ? 0x03 : 0x04);
+        out.push_back(instr.type == ir::Type::Void ? EMPTY_BLOCK : get_value_type(instr.type));
+        break;
+    case Opcode::Else:
+        out.push_back(0x05);
+        break;
+    case Opcode::End:
+        out.push_back(OP_END);
+        break;
+    case Opcode::Br:
+    case Opcode::BrIf:
+    case Opcode::Call:
+    case Opcode::LocalGet:
+    case Opcode::LocalSet:
+    case Opcode::GlobalGet:
+    case Opcode::GlobalSet:
+        out.push_back(instr.op == Opcode::Br          ? 0x0c
+                      : instr.op == Opcode::BrIf      ? 0x0d
+                      : instr.op == Opcode::Call      ? 0x10
+                      : instr.op == Opcode::LocalGet  ? 0x20
+                      : instr.op == Opcode::LocalSet  ? 0x21
+                      : instr.op == Opcode::GlobalGet ? 0x23
+                                                      : 0x24);
+        write_uleb(out, instr.imm);
+        break;
+    case Opcode::Return:
+        out.push_back(0x0f);
+        break;
+    case Opcode::Drop:
+        out.push_back(0x1a);
+        break;
+    case Opcode::Const:
+        out.push_back(typed(instr.type, 0x41, 0x42));
+        write_sleb(out, instr.imm);
+        break;
+    case Opcode::Eqz:
+        out.push_back(typed(instr.type, 0x45, 0x50));
+        break;
+    case Opcode::Eq:
+        out.push_back(typed(instr.type, 0x46, 0x51));
+        break;
+    case Opcode::LtS:
+        out.push_back(typed(instr.type, 0x48, 0x53));
+        break;
+    case Opcode::GtS:
+        out.push_back(typed(instr.type, 0x4a, 0x55));
+        break;
+    case Opcode::LeS:
+        out.push_back(typed(instr.type, 0x4c, 0x57));
+        break;
+    case Opcode::GeS:
+        out.push_back(typed(instr.type, 0x4e, 0x59));
+        break;
+    case Opcode::Add:
+        out.push_back(typed(instr.type, 0x6a, 0x7c));
+        break;
+    case Opcode::Sub:
+        out.push_back(typed(instr.type, 0x6b, 0x7d));
+        break;
+    case Opcode::Mul:
+        out.push_back(typed(instr.type, 0x6c, 0x7e));
+        break;
+    case Opcode::DivS:
+        out.push_back(typed(instr.type, 0x6d, 0x7f));
+        break;
+    case Opcode::And:
+        out.push_back(typed(instr.type, 0x71, 0x83));
+        break;
+    case Opcode::Or:
+        out.push_back(typed(instr.type, 0x72, 0x84));
+        break;
+    case Opcode::Wrap:
+        assert(instr.type == ir::Type::I64);
+        out.push_back(0xa7);
+        break;
+    case Opcode::ExtendU:
+        assert(instr.type == ir::Type::I32);
+        out.push_back(0xad);
+        break;
+    }
+}
+
+void WasmWriter::write_body(Bytes &out, const ir::Function &func) {
+    assert(func.locals.size() >= func.num_params);
+
+    Bytes body;
+
+    // all locals are i64, so they fit in a single declaration group
+    auto num_declared = func.locals.size() - func.num_params;
+    if (num_declared) {
+        write_uleb(body, 1);
+        write_uleb(body, num_declared);
+        body.push_back(TYPE_I64);
+    }
+    else {
+        write_uleb(body, 0);
+    }
+    for (const auto &instr : func.body) {
+        write_instr(body, instr);
+    }
+    body.push_back(OP_END);
+
+    write_uleb(out, body.size());
+    out.insert(out.end(), body.begin(), body.end());
+}
+
+WasmWriter::Bytes WasmWriter::write(const ir::Module &module) {
+    Bytes out = {0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00};
+    Bytes section;
+
+    // function signatures, (num_params, has_result) pairs
+    std::vector<std::pair<uint32_t, bool>> types;
+    std::vector<uint32_t> func_types;
+    func_types.reserve(module.funcs.size());
+    for (const auto &func : module.funcs) {
+        auto signature = std::make_pair(func.num_params, func.has_result);
+        auto iter = std::find(types.begin(), types.end(), signature);
+        func_types.push_back(iter - types.begin());
+        if (iter == types.end()) {
+            types.push_back(signature);
+        }
+    }
+
+    write_uleb(section, types.size());
+    for (auto [num_params, has_result] : types) {
+        section.push_back(TYPE_FUNC);
+        write_uleb(section, num_params);
+        section.insert(section.end(), num_params, TYPE_I64);
+        write_uleb(section, has_result ? 1 : 0);
+        if (has_result) {
+            section.push_back(TYPE_I64);
+        }
+    }
+    write_section(out, SECTION_TYPE, section);
+
+    section.clear();
+    write_uleb(section, func_types.size());
+    for (auto type : func_types) {
+        write_uleb(section, type);
+    }
+    write_section(out, SECTION_FUNCTION, section);
+
+    if (! module.globals.empty()) {
+        section.clear();
+        write_uleb(section, module.globals.size());
+        for (const auto &global : module.globals) {
+            section.push_back(TYPE_I64);
+            section.push_back(GLOBAL_MUTABLE);
+            assert(global.has_const_init());
+            write_instr(section, global.init[0]);
+            section.push_back(OP_END);
+        }
+        write_section(out, SECTION_GLOBAL, section);
+    }
+
+    section.clear();
+    write_uleb(section, std::count_if(module.funcs.begin(), module.funcs.end(),
+                                [](const auto &func) { return func.exported; }));
+    for (uint32_t i = 0; i < module.funcs.size(); ++i) {
+        if (module.funcs[i].exported) {
+            write_name(section, module.funcs[i].name.str());
+            section.push_back(EXPORT_FUNC);
+            write_uleb(section, i);
+        }
+    }
+    write_section(out, SECTION_EXPORT, section);
+
+    section.clear();
+    write_uleb(section, module.funcs.size());
+    for (const auto &func : module.funcs) {
+        write_body(section, func);
+    }
+    write_section(out, SECTION_CODE, section);
+
+    return out;
+}
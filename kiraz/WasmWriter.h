@@ -0,0 +1,33 @@
+#ifndef KIRAZ_WASMWRITER_H
+#define KIRAZ_WASMWRITER_H
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include <kiraz/ir/IR.h>
+
+/**
+ * @brief WasmWriter: Encodes an IR module as a WebAssembly binary module. Every value is an i64,
+ *        function signatures are deduplicated into the type section.
+ */
+class WasmWriter {
+public:
+    using Bytes = std::vector<uint8_t>;
+
+    /**
+     * @brief write: Returns the binary encoding of the given module.
+     */
+    static Bytes write(const ir::Module &module);
+
+    static void write_uleb(Bytes &out, uint64_t value);
+    static void write_sleb(Bytes &out, int64_t value);
+
+private:
+    static void write_name(Bytes &out, std::string_view name);
+    static void write_section(Bytes &out, uint8_t id, const Bytes &contents);
+    static void write_instr(Bytes &out, const ir::Instr &instr);
+    static void write_body(Bytes &out, const ir::Function &func);
+};
+
+#endif // KIRAZ_WASMWRITER_H
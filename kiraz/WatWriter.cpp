@@ -0,0 +1,144 @@
+
+#include "WatWriter.h"
+
+#include <cassert>
+#include <unordered_set>
+
+namespace {
+const char *get_type_name(ir::Type type) {
+    assert(type != ir::Type::Void);
+    return type == ir::Type::I32 ? "i32" : "i64";
+}
+
+void indent(OutputBuffer &out, size_t depth) {
+    static constexpr std::string_view spaces = "                                ";
+    for (depth *= 2; depth > spaces.size(); depth -= spaces.size()) {
+        out << spaces;
+    }
+    out << spaces.substr(0, depth);
+}
+} // namespace
+
+void WatWriter::write(const ir::Module &module, OutputBuffer &out) {
+    out << "(module\n";
+    for (const auto &global : module.globals) {
+        assert(global.has_const_init());
+        out << "  (global $" << global.name << " (mut i64) (i64.const " << global.init[0].imm
+            << "))\n";
+    }
+    for (const auto &func : module.funcs) {
+        write_func(module, func, out);
+    }
+    out << ")\n";
+}
+
+void WatWriter::write_func(const ir::Module &module, const ir::Function &func,
+        OutputBuffer &out) {
+    using ir::Opcode;
+
+    // shadowed names get their index appended, so every local keeps a distinct name
+    std::vector<bool> renamed(func.locals.size());
+    {
+        std::unordered_set<Symbol> seen;
+        for (size_t i = 0; i < func.locals.size(); ++i) {
+            renamed[i] = ! seen.insert(func.locals[i]).second;
+        }
+    }
+    auto local = [&](size_t index) -> OutputBuffer & {
+        out << '$' << func.locals[index];
+        if (renamed[index]) {
+            out << '.' << index;
+        }
+        return out;
+    };
+
+    out << "  (func $" << func.name;
+    if (func.exported) {
+        out << " (export \"" << func.name << "\")";
+    }
+    for (uint32_t i = 0; i < func.num_params; ++i) {
+        out << " (param ";
+        local(i) << " i64)";
+    }
+    if (func.has_result) {
+        out << " (result i64)";
+    }
+    out << '\n';
+
+    for (size_t i = func.num_params; i < func.locals.size(); ++i) {
+        out << "    (local ";
+        local(i) << " i64)\n";
+    }
+
+    size_t depth = 2;
+    for (const auto &instr : func.body) {
+        if (instr.op == Opcode::End || instr.op == Opcode::Else) {
+            assert(depth > 2);
+            indent(out, depth - 1);
+            if (instr.op == Opcode::End) {
+                --depth;
+            }
+        }
+        else {
+            indent(out, depth);
+        }
+
+        switch (instr.op) {
+        case Opcode::Block:
+        case Opcode::Loop:
+        case Opcode::If:
+            out << ir::get_name(instr.op);
+            if (instr.type != ir::Type::Void) {
+                out << " (result " << get_type_name(instr.type) << ')';
+            }
+            ++depth;
+            break;
+        case Opcode::Br:
+        case Opcode::BrIf:
+            out << ir::get_name(instr.op) << ' ' << instr.imm;
+            break;
+        case Opcode::Call:
+            out << "call $" << module.funcs[instr.imm].name;
+            break;
+        case Opcode::LocalGet:
+        case Opcode::LocalSet:
+            out << ir::get_name(instr.op) << ' ';
+            local(instr.imm);
+            break;
+        case Opcode::GlobalGet:
+        case Opcode::GlobalSet:
+            out << ir::get_name(instr.op) << " $" << module.globals[instr.imm].name;
+            break;
+        case Opcode::Const:
+            out << get_type_name(instr.type) << ".const " << instr.imm;
+            break;
+        case Opcode::Eqz:
+        case Opcode::Eq:
+        case Opcode::LtS:
+        case Opcode::GtS:
+        case Opcode::LeS:
+        case Opcode::GeS:
+        case Opcode::Add:
+        case Opcode::Sub:
+        case Opcode::Mul:
+        case Opcode::DivS:
+        case Opcode::And:
+        case Opcode::Or:
+            out << get_type_name(instr.type) << '.' << ir::get_name(instr.op);
+            break;
+        case Opcode::Wrap:
+            out << "i32.wrap_i64";
+            break;
+        case Opcode::ExtendU:
+            out << "i64.extend_i32_u";
+            break;
+        default:
+            out << ir::get_name(instr.op);
+            break;
+        }
+        out << '\n';
+    }
+    assert(depth == 2);
+
+    out << "  )\n";
+}
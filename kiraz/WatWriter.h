@@ -0,0 +1,22 @@
+#ifndef KIRAZ_WATWRITER_H
+#define KIRAZ_WATWRITER_H
+
+#include <kiraz/OutputBuffer.h>
+#include <kiraz/ir/IR.h>
+
+/**
+ * @brief WatWriter: Prints an IR module in the WebAssembly text format, one instruction per line
+ *        and indented by block nesting.
+ */
+class WatWriter {
+public:
+    /**
+     * @brief write: Appends the text of the given module to the buffer.
+     */
+    static void write(const ir::Module &module, OutputBuffer &out);
+
+private:
+    static void write_func(const ir::Module &module, const ir::Function &func, OutputBuffer &out);
+};
+
+#endif // KIRAZ_WATWRITER_H
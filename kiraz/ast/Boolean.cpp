@@ -1 +1,12 @@
-#include "Boolean.h"
\ No newline at end of file
+#include "Boolean.h"
+
+#include <kiraz/ir/IR.h>
+
+namespace ast {
+
+Node::Ptr Boolean::gen_ir(ir::Builder &b) {
+    b.i64_const(m_value ? 1 : 0);
+    return nullptr;
+}
+
+}
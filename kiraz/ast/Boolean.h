@@ -19,6 +19,8 @@ public:
     }
     void print() {fmt::print("{}\n", as_string());}
 
+    Node::Ptr gen_ir(ir::Builder &b) override;
+
 private:
     bool m_value;
 };
@@ -34,15 +34,15 @@ std::shared_ptr<BuiltinType> BuiltinManager::Function = []() {
 
 // Implementations for logical functions
 Node::Ptr BuiltinManager::AndFunction(Node::Ptr left, Node::Ptr right) {
-    return std::make_shared<OpAnd>(left, right);
+    return Node::make<OpAnd>(left, right);
 }
 
 Node::Ptr BuiltinManager::OrFunction(Node::Ptr left, Node::Ptr right) {
-    return std::make_shared<OpOr>(left, right);
+    return Node::make<OpOr>(left, right);
 }
 
 Node::Ptr BuiltinManager::NotFunction(Node::Ptr operand) {
-    return std::make_shared<OpNot>(operand);
+    return Node::make<OpNot>(operand);
 }
 
 } // namespace ast
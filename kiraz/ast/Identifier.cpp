@@ -1,17 +1,41 @@
 #include "Identifier.h"
+#include "Statement.h"
 #include <cassert>
-
-#include <kiraz/token/Identifier.h> 
+#include <kiraz/Compiler.h>
+#include <kiraz/ir/IR.h>
 
 namespace ast {
 
-Identifier::Identifier(const Token::Ptr &token) {
-    auto token_id = std::static_pointer_cast<const token::Identifier>(token);
-    if (token_id) {
-        m_name = token_id->get_value();
-    } else {
-        m_name = "invalid";
+Identifier::Identifier(Symbol name) : m_name(name) {
+    assert(name);
+}
+
+Node::Ptr Identifier::compute_stmt_type(SymbolTable &st) {
+    set_cur_symtab(st.get_cur_symtab());
+
+    // parameters live in the table of their function, the body only sees the function's scope
+    Node::Ptr symbol = st.lookup(m_name);
+    if (! symbol) {
+        if (auto func = std::dynamic_pointer_cast<FunctionStatement>(st.get_scope_stmt())) {
+            symbol = func->find_parameter(m_name);
+        }
+    }
+    if (symbol && symbol->get_stmt_type()) {
+        set_stmt_type(symbol->get_stmt_type());
+    }
+    return nullptr;
+}
+
+Node::Ptr Identifier::gen_ir(ir::Builder &b) {
+    if (auto local = b.find_local(m_name); local != ir::Builder::npos) {
+        b.op(ir::Opcode::LocalGet, local);
+        return nullptr;
+    }
+    if (auto global = b.find_global(m_name); global != ir::Builder::npos) {
+        b.op(ir::Opcode::GlobalGet, global);
+        return nullptr;
     }
+    return set_error(FF("Code generation is not supported for identifier '{}'", m_name));
 }
 
 }
\ No newline at end of file
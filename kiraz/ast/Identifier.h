@@ -1,19 +1,28 @@
 #ifndef KIRAZ_AST_IDENTIFIER_H
 #define KIRAZ_AST_IDENTIFIER_H
 
+#include <kiraz/Interner.h>
 #include <kiraz/Node.h>
 #include <string>
 namespace ast {
 
 class Identifier : public Node {
 private:
-    std::string  m_name;
+    Symbol m_name;
 
 public:
-    explicit Identifier(const Token::Ptr &token);
+    explicit Identifier(Symbol name);
 
     auto get_name() const { return m_name; }
 
+    /**
+     * @brief compute_stmt_type: Takes the type of the variable or parameter the name refers to.
+     *        A name that is not in view is left untyped, the statement using it reports that.
+     */
+    Node::Ptr compute_stmt_type(SymbolTable &st) override;
+
+    Node::Ptr gen_ir(ir::Builder &b) override;
+
     std::string as_string() const override {
         return fmt::format("Id({})", m_name);
     }
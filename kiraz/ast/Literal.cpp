@@ -2,24 +2,33 @@
 #include "Literal.h"
 
 #include <cassert>
+#include <kiraz/ir/IR.h>
 #include <kiraz/token/Literal.h>
 
 namespace ast {
-Integer::Integer(Token::Ptr t) {
-    auto token_int = std::static_pointer_cast<const token::Integer>(t);
-    m_base = token_int->get_base();
-    try {
-        m_value = std::stoll(token_int->get_value(), nullptr, m_base);
+Integer::Integer(int64_t value) : m_value(value) {
+    set_stmt_type(BuiltinManager::Integer64);
+}
+
+Node::Ptr Integer::gen_ir(ir::Builder &b) {
+    b.i64_const(m_value);
+    return nullptr;
+}
+
+Node::Ptr SignedNode::gen_ir(ir::Builder &b) {
+    if (m_operator != OP_MINUS) {
+        return std::const_pointer_cast<Node>(m_operand)->gen_ir(b);
     }
-    catch (std::out_of_range &e) {
-        m_value = 0;
+
+    b.i64_const(0);
+    if (auto ret = std::const_pointer_cast<Node>(m_operand)->gen_ir(b)) {
+        return ret;
     }
-    set_stmt_type(BuiltinManager::Integer64);
+    b.op(ir::Opcode::Sub, ir::Type::I64);
+    return nullptr;
 }
 
-String::String(Token::Ptr t) {
-    auto token_str = std::static_pointer_cast<const token::String>(t);
-    m_value = token_str->get_value();
+String::String(std::string_view text) : m_value(token::String::format_string(text)) {
     set_stmt_type(BuiltinManager::String);
 }
 
@@ -7,18 +7,15 @@
 namespace ast {
 class Integer : public Node {
 public:
-    Integer(Token::Ptr);
+    Integer(int64_t value);
+
+    auto get_value() const { return m_value; }
 
     std::string as_string() const override {return fmt::format("Int({})", m_value);}
-    // std::string as_string() const override { return fmt::format("Int({}, {})", m_base, m_value); }
 
-    Node::Ptr gen_wat(WasmContext &ctx) override {
-        ctx.body() << "  i64.const " << m_value << "\n";
-        return nullptr;
-    }
+    Node::Ptr gen_ir(ir::Builder &b) override;
 private:
     int64_t m_value;
-    int64_t m_base;
 };
 
 class SignedNode : public Node {
@@ -31,6 +28,8 @@ public:
         return fmt::format("Signed({}, {})", operator_to_string(m_operator), m_operand->as_string());
     }
 
+    Node::Ptr gen_ir(ir::Builder &b) override;
+
 private:
     int m_operator;
     Node::Cptr m_operand;
@@ -46,7 +45,7 @@ private:
 
 class String : public Node {
 public:
-    String(Token::Ptr t);
+    String(std::string_view text);
 
     std::string as_string() const override { 
         return fmt::format("Str({})", m_value); 
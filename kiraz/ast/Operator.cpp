@@ -15,45 +15,68 @@ OpAnd::OpAnd(Node::Ptr &left, Node::Ptr &right): m_left(left), m_right(right) {
 OpOr::OpOr(Node::Ptr &left, Node::Ptr &right): m_left(left), m_right(right) { set_stmt_type(BuiltinManager::Boolean); }
 
 Node::Ptr OpAdd::compute_stmt_type(SymbolTable &st) {
-    // std::cout << "left: " << get_left()->as_string() << std::endl;
-    // std::cout << "right: " << get_right()->as_string() << std::endl;
-
-    //     auto leftType = get_left()->get_stmt_type();
-    //     auto rightType = get_right()->get_stmt_type();
-
-    //     if (!leftType || !rightType) {
-    //         return set_error("Operand type cannot be determined");
-    //     }
-
-    //     if (leftType != rightType) {
-    //         return set_error(fmt::format(
-    //             "Operator '+' not defined for types '{}' and '{}'",
-    //             leftType->as_string(), rightType->as_string()));
-    //     }
-
-    //     if (leftType != BuiltinManager::Integer64 && leftType != BuiltinManager::String) {
-    //         return set_error(fmt::format(
-    //             "Operator '+' not supported for type '{}'", leftType->as_string()));
-    //     }
+    set_cur_symtab(st.get_cur_symtab());
+    if (auto ret = get_left()->compute_stmt_type(st)) {
+        return ret;
+    }
+    if (auto ret = get_right()->compute_stmt_type(st)) {
+        return ret;
+    }
 
-    //     return std::const_pointer_cast<Node>(leftType);
+    // operands of unknown or class types are left to code generation
+    auto left = std::dynamic_pointer_cast<const BuiltinType>(get_left()->get_stmt_type());
+    auto right = std::dynamic_pointer_cast<const BuiltinType>(get_right()->get_stmt_type());
+    if (! left || ! right) {
         return nullptr;
     }
+    if (left != right) {
+        return set_error(FF("Operator '+' not defined for types '{}' and '{}'", left->get_name(),
+                right->get_name()));
+    }
+    set_stmt_type(left);
+    return nullptr;
+}
 
-    Node::Ptr OpAdd::gen_wat(WasmContext &ctx) {
-        auto m_left = get_left();
-        auto m_right = get_right();
-        
-        if (m_left) {
-            m_left->gen_wat(ctx);
+    Node::Ptr OpBinary::gen_ir(ir::Builder &b) {
+        if (auto ret = m_left->gen_ir(b)) {
+            return ret;
         }
+        if (auto ret = m_right->gen_ir(b)) {
+            return ret;
+        }
+        gen_ir_op(b);
+        return nullptr;
+    }
 
-        if (m_right) {
-            m_right->gen_wat(ctx);
+    Node::Ptr OpNot::gen_ir(ir::Builder &b) {
+        if (auto ret = m_operand->gen_ir(b)) {
+            return ret;
         }
+        b.op(ir::Opcode::Eqz, ir::Type::I64);
+        b.op(ir::Opcode::ExtendU, ir::Type::I32);
+        return nullptr;
+    }
 
-        ctx.body() << "i64.add\n";
+    // booleans are 0 or 1, so the bitwise operators do, but both sides are always evaluated
+    Node::Ptr OpAnd::gen_ir(ir::Builder &b) {
+        if (auto ret = m_left->gen_ir(b)) {
+            return ret;
+        }
+        if (auto ret = m_right->gen_ir(b)) {
+            return ret;
+        }
+        b.op(ir::Opcode::And, ir::Type::I64);
+        return nullptr;
+    }
 
+    Node::Ptr OpOr::gen_ir(ir::Builder &b) {
+        if (auto ret = m_left->gen_ir(b)) {
+            return ret;
+        }
+        if (auto ret = m_right->gen_ir(b)) {
+            return ret;
+        }
+        b.op(ir::Opcode::Or, ir::Type::I64);
         return nullptr;
     }
 
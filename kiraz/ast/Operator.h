@@ -43,10 +43,17 @@ protected:
 
     virtual std::string operator_name() const = 0;
 
+    /**
+     * @brief gen_ir_op: Emits the instructions that combine the two operands on the stack.
+     */
+    virtual void gen_ir_op(ir::Builder &b) const = 0;
+
 public:
     auto get_left() const {return m_left;}
     auto get_right() const {return m_right;}
 
+    Node::Ptr gen_ir(ir::Builder &b) override;
+
     std::string as_string() const override {
         return fmt::format("{}(l={}, r={})", operator_name(), m_left->as_string(), m_right->as_string());
     }
@@ -59,6 +66,8 @@ class OpNot : public OpUnary {
 public:
     explicit OpNot(Node::Ptr &operand);
 
+    Node::Ptr gen_ir(ir::Builder &b) override;
+
 protected:
     std::string operator_name() const override { return "Not"; }
 };
@@ -68,10 +77,10 @@ public:
     OpAdd(const Node::Ptr &left, const Node::Ptr &right) : OpBinary(OP_PLUS, left, right) {}
 
     Node::Ptr compute_stmt_type(SymbolTable &st) override;
-    Node::Ptr gen_wat(WasmContext &ctx) override;
 
 protected:
     std::string operator_name() const override { return "Add"; }
+    void gen_ir_op(ir::Builder &b) const override { b.op(ir::Opcode::Add, ir::Type::I64); }
 };
 
 class OpSub : public OpBinary {
@@ -80,6 +89,7 @@ public:
 
 protected:
     std::string operator_name() const override { return "Sub"; }
+    void gen_ir_op(ir::Builder &b) const override { b.op(ir::Opcode::Sub, ir::Type::I64); }
 };
 
 class OpMult : public OpBinary {
@@ -88,6 +98,7 @@ public:
 
 protected:
     std::string operator_name() const override { return "Mult"; }
+    void gen_ir_op(ir::Builder &b) const override { b.op(ir::Opcode::Mul, ir::Type::I64); }
 };
 
 class OpDivF : public OpBinary {
@@ -96,6 +107,7 @@ public:
 
 protected:
     std::string operator_name() const override { return "DivF"; }
+    void gen_ir_op(ir::Builder &b) const override { b.op(ir::Opcode::DivS, ir::Type::I64); }
 };
 
 class OpEquals : public OpBinary {
@@ -104,6 +116,7 @@ public:
 
 protected:
     std::string operator_name() const override { return "OpEq"; }
+    void gen_ir_op(ir::Builder &b) const override { b.compare(ir::Opcode::Eq); }
 };
 
 class OpGT : public OpBinary {
@@ -112,6 +125,7 @@ public:
 
 protected:
     std::string operator_name() const override { return "OpGt"; }
+    void gen_ir_op(ir::Builder &b) const override { b.compare(ir::Opcode::GtS); }
 };
 
 class OpLT : public OpBinary {
@@ -120,6 +134,7 @@ public:
 
 protected:
     std::string operator_name() const override { return "OpLt"; }
+    void gen_ir_op(ir::Builder &b) const override { b.compare(ir::Opcode::LtS); }
 };
 
 class OpGE : public OpBinary {
@@ -128,6 +143,7 @@ public:
 
 protected:
     std::string operator_name() const override { return "OpGe"; }
+    void gen_ir_op(ir::Builder &b) const override { b.compare(ir::Opcode::GeS); }
 };
 
 class OpLE : public OpBinary {
@@ -136,6 +152,7 @@ public:
 
 protected:
     std::string operator_name() const override { return "OpLe"; }
+    void gen_ir_op(ir::Builder &b) const override { b.compare(ir::Opcode::LeS); }
 };
 
 class OpAssign : public Node {
@@ -167,6 +184,8 @@ private:
 public:
     OpAnd(Node::Ptr &left, Node::Ptr &right);
 
+    Node::Ptr gen_ir(ir::Builder &b) override;
+
     auto get_left() const { return m_left; }
     auto get_right() const { return m_right; }
 
@@ -183,6 +202,8 @@ private:
 public:
     OpOr(Node::Ptr &left, Node::Ptr &right);
 
+    Node::Ptr gen_ir(ir::Builder &b) override;
+
     auto get_left() const { return m_left; }
     auto get_right() const { return m_right; }
 
@@ -1,32 +1,124 @@
 #include "Statement.h"
 #include "Literal.h"
+#include <kiraz/ModuleInterface.h>
+#include <kiraz/Trace.h>
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <memory>
 
 namespace ast {
 
+    /* Name of a function, class or variable declaration, null for other statements */
+    static Symbol get_decl_name(const Node::Cptr &stmt) {
+        Node::Ptr name;
+        if (auto func = std::dynamic_pointer_cast<const FunctionStatement>(stmt)) {
+            name = func->get_name();
+        }
+        else if (auto cls = std::dynamic_pointer_cast<const ClassStatement>(stmt)) {
+            name = cls->get_name();
+        }
+        else if (auto let = std::dynamic_pointer_cast<const LetStatement>(stmt)) {
+            name = let->get_identifier();
+        }
+        auto id = std::dynamic_pointer_cast<Identifier>(name);
+        return id ? id->get_name() : Symbol();
+    }
+
+    /* Names a top level statement in traces */
+    static std::string_view get_trace_label(const Node::Ptr &stmt) {
+        auto name = get_decl_name(stmt);
+        return name ? std::string_view(name.str()) : std::string_view();
+    }
+
+    /*
+     * Types are builtin types or classes. A type that is unknown, because it was not declared or
+     * is not checked yet, stays null and the checks below let it pass.
+     */
+    static Node::Cptr resolve_type(const Node::Ptr &annotation, const SymbolTable &st) {
+        if (std::dynamic_pointer_cast<BuiltinType>(annotation)) {
+            return annotation;
+        }
+        auto id = std::dynamic_pointer_cast<Identifier>(annotation);
+        if (! id) {
+            return nullptr;
+        }
+        if (auto builtin = BuiltinManager::get_builtin_type(id->get_name())) {
+            return builtin;
+        }
+        return std::dynamic_pointer_cast<ClassStatement>(st.lookup(id->get_name()));
+    }
+
+    static std::string get_type_name(const Node::Cptr &type) {
+        if (auto builtin = std::dynamic_pointer_cast<const BuiltinType>(type)) {
+            return builtin->get_name();
+        }
+        if (std::dynamic_pointer_cast<const ClassStatement>(type)) {
+            return get_decl_name(type).str();
+        }
+        return type->as_string();
+    }
+
+    /* A class may be used where one of its ancestors is expected */
+    static bool is_assignable(const Node::Cptr &to, const Node::Cptr &from, const SymbolTable &st) {
+        for (auto type = from; type;) {
+            if (type == to) {
+                return true;
+            }
+            auto cls = std::dynamic_pointer_cast<const ClassStatement>(type);
+            auto parent = cls ? resolve_type(cls->get_parent_class(), st) : nullptr;
+            type = parent != type ? parent : nullptr;
+        }
+        return false;
+    }
+
+    /* io.print takes any builtin type, the prelude only declares the String one */
+    static bool is_io_print(const Node::Ptr &func) {
+        if (get_decl_name(func).str() != "print") {
+            return false;
+        }
+        auto io = std::dynamic_pointer_cast<Module>(SymbolTable::get_module_io());
+        if (! io) {
+            return false;
+        }
+        const auto &stmts = StatementList::statements_of(io->get_statements());
+        return std::find(stmts.begin(), stmts.end(), func) != stmts.end();
+    }
+
     // Module
     Node::Ptr Module::compute_stmt_type(SymbolTable &st) {
         if(m_statements) {
             assert(m_statements->is_stmt_list());
             set_cur_symtab(st.get_cur_symtab());
 
-            auto current = std::dynamic_pointer_cast<StatementList>(m_statements);
-            while (current) {
-                if (current->get_first()) {
-                    if (auto ret = current->get_first()->add_to_symtab_forward(st)) {
-                        return ret;
-                    }
-                    if (auto ret = current->get_first()->add_to_symtab_ordered(*m_symtab)) {
-                        return ret;
-                    }
-                    if (auto ret = current->get_first()->compute_stmt_type(st)) {
-                        return ret;
+            auto &stats = Compiler::current()->get_stats();
+
+            // functions may be called ahead of their definition, so they are all in view up front
+            {
+                CompileStats::Scope phase(stats, CompileStats::Phase::SymtabForward);
+                for (const auto &stmt : StatementList::statements_of(m_statements)) {
+                    auto name = get_decl_name(stmt);
+                    if (! std::dynamic_pointer_cast<FunctionStatement>(stmt) || st.is_builtin(name)
+                            || st.lookup(name)) {
+                        continue;
                     }
+                    st.add_symbol(name, stmt);
+                }
+            }
+
+            for (const auto &stmt : StatementList::statements_of(m_statements)) {
+                if (CompileStats::Scope phase(stats, CompileStats::Phase::SymtabForward);
+                        auto ret = stmt->add_to_symtab_forward(st)) {
+                    return ret;
+                }
+                if (CompileStats::Scope phase(stats, CompileStats::Phase::SymtabOrdered);
+                        auto ret = stmt->add_to_symtab_ordered(*m_symtab)) {
+                    return ret;
+                }
+                if (Trace::Span span("compute_stmt_type", get_trace_label(stmt));
+                        auto ret = stmt->compute_stmt_type(st)) {
+                    return ret;
                 }
-                current = std::dynamic_pointer_cast<StatementList>(current->get_next());
-                // st.print();
             }
         }
 
@@ -49,23 +141,6 @@ namespace ast {
         return nullptr;
     }
 
-    Node::Ptr Module::gen_wat(WasmContext &ctx) {
-        ctx.body() << "(module\n";
-        
-        if (m_statements) {
-            auto current = std::dynamic_pointer_cast<StatementList>(m_statements);
-            while (current) {
-                if (auto stmt = current->get_first()) {
-                    stmt->gen_wat(ctx);
-                }
-                current = std::dynamic_pointer_cast<StatementList>(current->get_next());
-            }
-        }
-
-        ctx.body() << ")\n";
-        return nullptr;
-    }
-
 
     // ImportStatement
     Node::Ptr ImportStatement::compute_stmt_type(SymbolTable &st) {
@@ -79,9 +154,6 @@ namespace ast {
         return nullptr;
     }
 
-    Node::Ptr ImportStatement::add_to_symtab_forward(SymbolTable &st) {
-        return nullptr;
-    }
 
     void ImportStatement::integrate_module_symbols(Node::Ptr moduleAST, SymbolTable &st) {
         if (!moduleAST) {
@@ -92,23 +164,16 @@ namespace ast {
         if(!stmts) {
             return;
         }
-        auto stmtList = std::dynamic_pointer_cast<StatementList>(stmts);
-        if(!stmtList) return;
-        auto current = stmtList;
-        while (current) {
-            if (current->get_first()) {
-                auto first = current->get_first();
-
-                if (auto ret = first->add_to_symtab_ordered(st)) {
-                    std::cerr << "Error in add_to_symtab_ordered: " << ret->as_string() << std::endl;
-                    return;
-                }
+        for (const auto &first : StatementList::statements_of(stmts)) {
+            if (auto ret = first->add_to_symtab_ordered(st)) {
+                std::cerr << "Error in add_to_symtab_ordered: " << ret->as_string() << std::endl;
+                return;
             }
-            current = std::dynamic_pointer_cast<StatementList>(current->get_next());
         }
     }
 
-    Node::Ptr ImportStatement::add_to_symtab_ordered(SymbolTable &st) {
+    // the module level table is only handed to the forward pass, so imports are resolved there
+    Node::Ptr ImportStatement::add_to_symtab_forward(SymbolTable &st) {
         if(m_identifier) {
             auto id = std::dynamic_pointer_cast<Identifier>(m_identifier);
             if (!id) {
@@ -127,41 +192,69 @@ namespace ast {
                 }
 
                 integrate_module_symbols(ioModule, st);
-                
+
+                // its declarations are reached as members, eg. io.print
+                st.add_symbol(id->get_name(), ioModule);
             } else {
                 std::string filePath = resolve_module_path(moduleName);
                 if (filePath.empty()) {
                     return set_error(FF("Module '{}' not found", moduleName));
                 }
 
-                std::ifstream file(filePath);
-                if (!file.is_open()) {
+                ModuleInterface::Stamp stamp;
+                if (!ModuleInterface::Stamp::of(filePath, stamp)) {
                     return set_error(fmt::format("Unable to open file '{}'", filePath));
                 }
-
-                std::string fileContent((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-                file.close();
-
-                auto moduleAST = Compiler::current()->compile_module(fileContent);
-                if (!moduleAST) {
-                    return set_error(fmt::format("Failed to parse module '{}'", moduleName));
+                Compiler::current()->add_dependency(filePath, stamp);
+
+                // an interface made from this very source spares parsing the module again
+                auto interface = std::make_shared<ModuleInterface>();
+                if (!interface->load(filePath, stamp)) {
+                    // the parser leaves its reason on the compiler
+                    const auto &reason = Compiler::current()->get_error();
+                    if (reason.empty()) {
+                        return set_error(FF("Failed to parse module '{}'", moduleName));
+                    }
+                    return set_error(FF("Failed to parse module '{}': {}", moduleName, reason));
                 }
 
-                integrate_module_symbols(moduleAST, st);
+                if (auto name = st.add_import(std::move(interface))) {
+                    return set_error(FF("Identifier '{}' is already in symtab", name.str()));
+                }
             }
         }
         return nullptr;
     }
 
+    Node::Ptr ImportStatement::add_to_symtab_ordered(SymbolTable &st) {
+        return nullptr;
+    }
+
     // CallStatement
     Node::Ptr CallStatement::compute_stmt_type(SymbolTable &st) {
+        set_cur_symtab(st.get_cur_symtab());
+        if (auto dot = std::dynamic_pointer_cast<OpDot>(m_callee)) {
+            if (auto ret = dot->compute_stmt_type(st)) {
+                return ret;
+            }
+            auto func = std::dynamic_pointer_cast<FunctionStatement>(dot->get_member());
+            if (! func) {
+                return nullptr;
+            }
+            auto left = std::dynamic_pointer_cast<Identifier>(dot->get_left());
+            auto right = std::dynamic_pointer_cast<Identifier>(dot->get_right());
+            return check_call(func, FF("{}.{}", left->get_name(), right->get_name()), st);
+        }
         if(m_callee) {
             auto callee_id = std::dynamic_pointer_cast<Identifier>(m_callee);
             if (callee_id) {
                 auto callee_symbol = st.lookup(callee_id->get_name());
                 if (!callee_symbol) {
-                    // return set_error(fmt::format("Variable '{}' is not defined.", callee_id->get_name()));
-                    return nullptr;
+                    return set_error(FF("Identifier '{}' is not found", callee_id->get_name()));
+                }
+
+                if (auto func = std::dynamic_pointer_cast<FunctionStatement>(callee_symbol)) {
+                    return check_call(func, callee_id->get_name(), st);
                 }
 
                 auto class_stmt = std::dynamic_pointer_cast<ClassStatement>(callee_symbol);
@@ -196,6 +289,47 @@ namespace ast {
         return nullptr;
     }
 
+    Node::Ptr CallStatement::check_call(const std::shared_ptr<FunctionStatement> &func,
+            const std::string &name, SymbolTable &st) {
+        const auto &args = ParameterList::parameters_of(m_arguments);
+        const auto &params = ParameterList::parameters_of(func->get_parameters());
+        if (args.size() != params.size()) {
+            return set_error(FF("Call to function '{}' has wrong number of arguments", name));
+        }
+
+        bool any_builtin = is_io_print(func);
+        for (size_t i = 0; i < args.size(); ++i) {
+            // call arguments are parsed as untyped parameters
+            auto param = std::dynamic_pointer_cast<Parameter>(args[i]);
+            auto value = param ? param->get_name() : args[i];
+            if (auto ret = value->compute_stmt_type(st)) {
+                return ret;
+            }
+
+            auto type = value->get_stmt_type();
+            if (! type) {
+                continue;
+            }
+            if (any_builtin && ! std::dynamic_pointer_cast<const BuiltinType>(type)) {
+                return set_error(FF("Argument {} in call to function '{}' has type '{}' which is "
+                                    "not a builtin type",
+                        i + 1, name, get_type_name(type)));
+            }
+            auto declared = std::static_pointer_cast<Parameter>(params[i])->get_type();
+            auto expected = resolve_type(declared, st);
+            if (! any_builtin && expected && ! is_assignable(expected, type, st)) {
+                return set_error(FF("Argument {} in call to function '{}' has type '{}' which does "
+                                    "not match definition type '{}'",
+                        i + 1, name, get_type_name(type), get_type_name(expected)));
+            }
+        }
+
+        if (auto type = resolve_type(func->get_return_type(), st)) {
+            set_stmt_type(type);
+        }
+        return nullptr;
+    }
+
     Node::Ptr CallStatement::add_to_symtab_forward(SymbolTable &st) {
         if(m_callee) 
             m_callee->add_to_symtab_forward(st);
@@ -232,50 +366,44 @@ namespace ast {
         }
     
         if (m_stmts) {
-            auto current = std::dynamic_pointer_cast<StatementList>(m_stmts);
-            while (current) {
-                if (current->get_first()) {
-                    auto member = current->get_first();
-
-                    // Check if it's a LetStatement (variable declaration)
-                    auto letStmt = std::dynamic_pointer_cast<LetStatement>(member);
-                    if (letStmt && letStmt->get_identifier()) {
-                        auto id = std::dynamic_pointer_cast<Identifier>(letStmt->get_identifier());
-                        if (id) {
-                            if (parentSymTab && parentSymTab->lookup(id->get_name())) {
-                                return set_error(fmt::format(
-                                    "Identifier '{}' is already in symtab",
-                                    id->get_name()
-                                ));
-                            }
+            for (const auto &member : StatementList::statements_of(m_stmts)) {
+                // Check if it's a LetStatement (variable declaration)
+                auto letStmt = std::dynamic_pointer_cast<LetStatement>(member);
+                if (letStmt && letStmt->get_identifier()) {
+                    auto id = std::dynamic_pointer_cast<Identifier>(letStmt->get_identifier());
+                    if (id) {
+                        if (parentSymTab && parentSymTab->lookup(id->get_name())) {
+                            return set_error(fmt::format(
+                                "Identifier '{}' is already in symtab",
+                                id->get_name()
+                            ));
                         }
                     }
+                }
 
-                    // Check if it's a FunctionStatement (method declaration)
-                    auto funcStmt = std::dynamic_pointer_cast<FunctionStatement>(member);
-                    if (funcStmt && funcStmt->get_name()) {
-                        auto id = std::dynamic_pointer_cast<Identifier>(funcStmt->get_name());
-                        if (id) {
-                            if (parentSymTab && parentSymTab->lookup(id->get_name())) {
-                                return set_error(fmt::format(
-                                    "Identifier '{}' is already in symtab",
-                                    id->get_name()
-                                ));
-                            }
+                // Check if it's a FunctionStatement (method declaration)
+                auto funcStmt = std::dynamic_pointer_cast<FunctionStatement>(member);
+                if (funcStmt && funcStmt->get_name()) {
+                    auto id = std::dynamic_pointer_cast<Identifier>(funcStmt->get_name());
+                    if (id) {
+                        if (parentSymTab && parentSymTab->lookup(id->get_name())) {
+                            return set_error(fmt::format(
+                                "Identifier '{}' is already in symtab",
+                                id->get_name()
+                            ));
                         }
                     }
+                }
 
-                    if (auto ret = current->get_first()->add_to_symtab_forward(st)) {
-                        return ret;
-                    }
-                    if (auto ret = current->get_first()->add_to_symtab_ordered(*m_symtab)) {
-                        return ret;
-                    }
-                    if (auto ret = current->get_first()->compute_stmt_type(st)) {
-                        return ret;
-                    }
+                if (auto ret = member->add_to_symtab_forward(st)) {
+                    return ret;
+                }
+                if (auto ret = member->add_to_symtab_ordered(*m_symtab)) {
+                    return ret;
+                }
+                if (auto ret = member->compute_stmt_type(st)) {
+                    return ret;
                 }
-                current = std::dynamic_pointer_cast<StatementList>(current->get_next());
             }
         }
         return nullptr;
@@ -306,15 +434,11 @@ namespace ast {
             }
         }
         if (m_stmts) {
-            auto current = std::dynamic_pointer_cast<StatementList>(m_stmts);
-            while (current) {
-                if (current->get_first()) {
-                    auto ret = current->get_first()->add_to_symtab_ordered(*m_symtab);
-                    if (ret) {
-                        return ret;
-                    }
+            for (const auto &stmt : StatementList::statements_of(m_stmts)) {
+                auto ret = stmt->add_to_symtab_ordered(*m_symtab);
+                if (ret) {
+                    return ret;
                 }
-                current = std::dynamic_pointer_cast<StatementList>(current->get_next());
             }
         }
         // st.print();
@@ -327,33 +451,27 @@ Node::Ptr ClassStatement::add_to_symtab_ordered(SymbolTable &st) {
     }
 
     if (m_stmts) {
-        auto current = std::dynamic_pointer_cast<StatementList>(m_stmts);
-        while (current) {
-            if (current->get_first()) {
-                auto member = current->get_first();
-                
-                // Check if it's a LetStatement (variable declaration)
-                auto letStmt = std::dynamic_pointer_cast<LetStatement>(member);
-                if (letStmt && letStmt->get_identifier()) {
-                    auto id = std::dynamic_pointer_cast<Identifier>(letStmt->get_identifier());
-                    if (id) {
-                        // if(m_symtab->lookup(id->get_name())) {
-                        //     return set_error(FF("Identifier '{}' is already in symtab", id->get_name()));
-                        // }
-                        m_symtab->add_symbol(id->get_name(), member);
-                    }
+        for (const auto &member : StatementList::statements_of(m_stmts)) {
+            // Check if it's a LetStatement (variable declaration)
+            auto letStmt = std::dynamic_pointer_cast<LetStatement>(member);
+            if (letStmt && letStmt->get_identifier()) {
+                auto id = std::dynamic_pointer_cast<Identifier>(letStmt->get_identifier());
+                if (id) {
+                    // if(m_symtab->lookup(id->get_name())) {
+                    //     return set_error(FF("Identifier '{}' is already in symtab", id->get_name()));
+                    // }
+                    m_symtab->add_symbol(id->get_name(), member);
                 }
+            }
 
-                // Check if it's a FunctionStatement (method declaration)
-                auto funcStmt = std::dynamic_pointer_cast<FunctionStatement>(member);
-                if (funcStmt && funcStmt->get_name()) {
-                    auto id = std::dynamic_pointer_cast<Identifier>(funcStmt->get_name());
-                    if (id) {
-                        m_symtab->add_symbol(id->get_name(), member);
-                    }
+            // Check if it's a FunctionStatement (method declaration)
+            auto funcStmt = std::dynamic_pointer_cast<FunctionStatement>(member);
+            if (funcStmt && funcStmt->get_name()) {
+                auto id = std::dynamic_pointer_cast<Identifier>(funcStmt->get_name());
+                if (id) {
+                    m_symtab->add_symbol(id->get_name(), member);
                 }
             }
-            current = std::dynamic_pointer_cast<StatementList>(current->get_next());
         }
     }
     // m_symtab->print();
@@ -367,7 +485,21 @@ Node::Ptr ClassStatement::add_to_symtab_ordered(SymbolTable &st) {
         if(st.get_scope_type() != ScopeType::Func) {
             return  set_error(FF("Misplaced return statement"));
         }
-        return m_expression->compute_stmt_type(st);
+        if (auto ret = m_expression->compute_stmt_type(st)) {
+            return ret;
+        }
+
+        // Void functions may return a value, it is dropped
+        auto func = std::dynamic_pointer_cast<FunctionStatement>(st.get_scope_stmt());
+        auto expected = func ? resolve_type(func->get_return_type(), st) : nullptr;
+        auto type = m_expression->get_stmt_type();
+        if (type && expected && expected != BuiltinManager::Void
+                && ! is_assignable(expected, type, st)) {
+            return set_error(FF("Return statement type '{}' does not match function return type "
+                                "'{}'",
+                    get_type_name(type), get_type_name(expected)));
+        }
+        return nullptr;
     }
 
     Node::Ptr ReturnStatement::add_to_symtab_forward(SymbolTable &st) {
@@ -386,9 +518,11 @@ Node::Ptr ClassStatement::add_to_symtab_ordered(SymbolTable &st) {
             if (id && stmt_name) {
                 if(m_type) {
                     auto type = std::dynamic_pointer_cast<Identifier>(m_type);
-                    if(!BuiltinManager::get_builtin_type(type->get_name())){
+                    auto builtin = BuiltinManager::get_builtin_type(type->get_name());
+                    if(!builtin){
                         return set_error(FF("Identifier '{}' in type of argument '{}' in function '{}' is not found", type->get_name(), id->get_name(), stmt_name->get_name()));
                     }
+                    set_stmt_type(builtin);
                     return m_type->compute_stmt_type(st);
                 } 
                 if(st.lookup(id->get_name())) {
@@ -453,67 +587,86 @@ Node::Ptr Parameter::add_to_symtab_ordered(SymbolTable &st) {
 }
 
     // ParameterList
+    const std::vector<Node::Ptr> &ParameterList::parameters_of(const Node::Ptr &node) {
+        static const std::vector<Node::Ptr> none;
+        auto list = std::dynamic_pointer_cast<ParameterList>(node);
+        return list ? list->m_parameters : none;
+    }
+
+    std::string ParameterList::as_string() const {
+        std::string result;
+        for (const auto &param : m_parameters) {
+            if (! result.empty()) {
+                result += ", ";
+            }
+            result += param->as_string();
+        }
+        return result;
+    }
+
     Node::Ptr ParameterList::compute_stmt_type(SymbolTable &st) {
-        if (m_first) {
-            Node::Ptr error = m_first->compute_stmt_type(st);
-            if (error) return error;
-            if (m_next) {
-                return m_next->compute_stmt_type(st);
+        for (const auto &param : m_parameters) {
+            if (auto error = param->compute_stmt_type(st)) {
+                return error;
             }
         }
         return nullptr;
     }
 
+    // only the outcome for the last parameter is reported, as when the list was nested
     Node::Ptr ParameterList::add_to_symtab_forward(SymbolTable &st) {
         Node::Ptr error = nullptr;
-        if (m_first) {
-            error = m_first->add_to_symtab_forward(st);
-        }
-        if (m_next) {
-            error = m_next->add_to_symtab_forward(st);
+        for (const auto &param : m_parameters) {
+            error = param->add_to_symtab_forward(st);
         }
         return error;
     }
 
     Node::Ptr ParameterList::add_to_symtab_ordered(SymbolTable &st) {
         Node::Ptr error = nullptr;
-        if (m_first) {
-            error = m_first->add_to_symtab_ordered(st);
-        }
-        if (m_next) {
-            error = m_next->add_to_symtab_ordered(st);
+        for (const auto &param : m_parameters) {
+            error = param->add_to_symtab_ordered(st);
         }
         return error;
     }
 
     // StatementList
+    const std::vector<Node::Ptr> &StatementList::statements_of(const Node::Ptr &node) {
+        static const std::vector<Node::Ptr> none;
+        auto list = std::dynamic_pointer_cast<StatementList>(node);
+        return list ? list->m_statements : none;
+    }
+
+    std::string StatementList::as_string() const {
+        std::string result;
+        for (const auto &stmt : m_statements) {
+            if (! result.empty()) {
+                result += ", ";
+            }
+            result += stmt->as_string();
+        }
+        return result;
+    }
+
     Node::Ptr StatementList::compute_stmt_type(SymbolTable &st) {
-        if (m_first) {
-            Node::Ptr error = m_first->compute_stmt_type(st);
-            if (error) return error;
-            if (m_next) {
-                return m_next->compute_stmt_type(st);
+        for (const auto &stmt : m_statements) {
+            if (auto error = stmt->compute_stmt_type(st)) {
+                return error;
             }
         }
         return nullptr;
     }
 
     Node::Ptr StatementList::add_to_symtab_forward(SymbolTable &st) {
-        if (m_first) {
-            m_first->add_to_symtab_forward(st);
-        }
-        if (m_next) {
-            m_next->add_to_symtab_forward(st);
+        for (const auto &stmt : m_statements) {
+            stmt->add_to_symtab_forward(st);
         }
         return nullptr;
     }
 
     Node::Ptr StatementList::add_to_symtab_ordered(SymbolTable &st) {
-        if (m_first) {
-            m_first->add_to_symtab_ordered(st);
-        }
-        if (m_next) {
-            m_next->add_to_symtab_ordered(st);
+        for (const auto &stmt : m_statements) {
+            stmt->add_to_symtab_ordered(st);
         }
         return nullptr;
     }
@@ -543,26 +696,22 @@ Node::Ptr Parameter::add_to_symtab_ordered(SymbolTable &st) {
         if (m_body) {
             assert(m_body->is_stmt_list());
 
-            auto current = std::dynamic_pointer_cast<StatementList>(m_body);
-            while (current) {
-                if (current->get_first()) {
-                    auto id = std::dynamic_pointer_cast<Identifier>(current->get_first());
-                    if(id) {
-                        if(!st.lookup(id->get_name())) {
-                            return set_error(FF("Identifier '{}' is not found", id->get_name()));
-                        }
-                    }
-                    if (auto ret = current->get_first()->add_to_symtab_forward(st)) {
-                        return ret;
-                    }
-                    if (auto ret = current->get_first()->add_to_symtab_ordered(*m_symtab)) {
-                        return ret;
-                    }
-                    if (auto ret = current->get_first()->compute_stmt_type(st)) {
-                        return ret;
+            for (const auto &stmt : StatementList::statements_of(m_body)) {
+                auto id = std::dynamic_pointer_cast<Identifier>(stmt);
+                if(id) {
+                    if(!st.lookup(id->get_name())) {
+                        return set_error(FF("Identifier '{}' is not found", id->get_name()));
                     }
                 }
-                current = std::dynamic_pointer_cast<StatementList>(current->get_next());
+                if (auto ret = stmt->add_to_symtab_forward(st)) {
+                    return ret;
+                }
+                if (auto ret = stmt->add_to_symtab_ordered(*m_symtab)) {
+                    return ret;
+                }
+                if (auto ret = stmt->compute_stmt_type(st)) {
+                    return ret;
+                }
             }
         }
         // st.print();
@@ -577,7 +726,8 @@ Node::Ptr Parameter::add_to_symtab_ordered(SymbolTable &st) {
             if (st.is_builtin(id->get_name())) {
                 return set_error(FF("Identifier '{}' is a built-in type and cannot be used as an identifier", id->get_name()));
             }
-            if(st.lookup(id->get_name())) {
+            // the module binds its functions ahead, see Module::compute_stmt_type()
+            if (auto prev = st.lookup(id->get_name()); prev && prev != shared_from_this()) {
                 return set_error(FF("Identifier '{}' is already in symtab", id->get_name()));
             }
             st.add_symbol(id->get_name(), shared_from_this());
@@ -596,63 +746,31 @@ Node::Ptr Parameter::add_to_symtab_ordered(SymbolTable &st) {
             }
         }
         if (m_body) {
-            auto current = std::dynamic_pointer_cast<StatementList>(m_body);
-            while (current) {
-                if (current->get_first()) {
-                    auto ret = current->get_first()->add_to_symtab_ordered(*m_symtab);
-                    if (ret) return ret;
-                }
-                current = std::dynamic_pointer_cast<StatementList>(current->get_next());
+            for (const auto &stmt : StatementList::statements_of(m_body)) {
+                auto ret = stmt->add_to_symtab_ordered(*m_symtab);
+                if (ret) return ret;
             }
         }
         return nullptr;
     }
 
-Node::Ptr FunctionStatement::gen_wat(WasmContext &ctx) {
-    auto nameID = std::dynamic_pointer_cast<Identifier>(m_name);
-    ctx.body() << "(func $" << nameID->get_name() << "\n";
 
-    if (m_parameters) {
-        auto current = std::dynamic_pointer_cast<ParameterList>(m_parameters);
-        while (current) {
-            if (auto param = current->get_first()) {
-                auto p = std::dynamic_pointer_cast<Parameter>(param);
-                auto id = std::dynamic_pointer_cast<Identifier>(p->get_name());
-                if (id) {
-                    ctx.body() << "  (param $" << id->get_name() << " i64)\n";
-                }
-            }
-            current = std::dynamic_pointer_cast<ParameterList>(current->get_next());
-        }
-    }
 
-    if (m_returnType) {
-        ctx.body() << "  (result i64)\n";
-    }
-
-
-    if (m_body) {
-        auto current = std::dynamic_pointer_cast<StatementList>(m_body);
-        while (current) {
-            if (auto stmt = current->get_first()) {
-                stmt->gen_wat(ctx);
+    Node::Ptr LetStatement::compute_stmt_type(SymbolTable &st) {
+        if (m_value) {
+            if (auto ret = m_value->compute_stmt_type(st)) {
+                return ret;
             }
-            current = std::dynamic_pointer_cast<StatementList>(current->get_next());
         }
-    }
-
-    ctx.body() << ctx.locals().str();
-    ctx.locals().str("");
-    ctx.body() << ")\n";
-    return nullptr;
-}
-
 
-
-
-    Node::Ptr LetStatement::compute_stmt_type(SymbolTable &st) {
-        if (m_value) {
-            return m_value->compute_stmt_type(st);
+        auto type = resolve_type(m_type, st);
+        auto value_type = m_value ? m_value->get_stmt_type() : nullptr;
+        if (type && value_type && ! is_assignable(type, value_type, st)) {
+            return set_error(FF("Initializer type '{}' does not match explicit type '{}'",
+                    get_type_name(value_type), get_type_name(type)));
+        }
+        if (auto known = type ? type : value_type) {
+            set_stmt_type(known);
         }
         return nullptr;
     }
@@ -691,7 +809,9 @@ Node::Ptr FunctionStatement::gen_wat(WasmContext &ctx) {
                 if (st.is_builtin(id->get_name())) {
                     return set_error(fmt::format("Overriding builtin '{}' is not allowed", id->get_name()));
                 }
-                return m_left->compute_stmt_type(st);
+                if (auto ret = m_left->compute_stmt_type(st)) {
+                    return ret;
+                }
             }
             auto dotExpr = std::dynamic_pointer_cast<OpDot>(m_left);
             if (dotExpr) {
@@ -707,6 +827,13 @@ Node::Ptr FunctionStatement::gen_wat(WasmContext &ctx) {
                 return rightError;
             }
         }
+
+        auto left_type = m_left ? m_left->get_stmt_type() : nullptr;
+        auto right_type = m_right ? m_right->get_stmt_type() : nullptr;
+        if (left_type && right_type && ! is_assignable(left_type, right_type, st)) {
+            return set_error(FF("Left type '{}' of assignment does not match the right type '{}'",
+                    get_type_name(left_type), get_type_name(right_type)));
+        }
         return nullptr;
     }
 
@@ -814,7 +941,30 @@ Node::Ptr FunctionStatement::gen_wat(WasmContext &ctx) {
 
         auto leftSymbol = st.lookup(leftIdentifier->get_name());
         if (!leftSymbol) {
-            return set_error(fmt::format("Object '{}' is not defined", leftIdentifier->get_name()));
+            return set_error(fmt::format("Identifier '{}' is not found", leftIdentifier->get_name()));
+        }
+
+        auto rightIdentifier = std::dynamic_pointer_cast<Identifier>(m_right);
+        if (!rightIdentifier) {
+            return set_error("Right-hand side of dot expression must be an identifier");
+        }
+
+        // an imported module, eg. io
+        if (auto module = std::dynamic_pointer_cast<Module>(leftSymbol)) {
+            for (const auto &stmt : StatementList::statements_of(module->get_statements())) {
+                if (get_decl_name(stmt) == rightIdentifier->get_name()) {
+                    m_member = stmt;
+                    break;
+                }
+            }
+            if (! m_member) {
+                return set_error(FF("Identifier '{}.{}' is not found", leftIdentifier->get_name(),
+                        rightIdentifier->get_name()));
+            }
+            if (m_member->get_stmt_type()) {
+                set_stmt_type(m_member->get_stmt_type());
+            }
+            return nullptr;
         }
 
         auto leftClass = std::dynamic_pointer_cast<ClassStatement>(leftSymbol);
@@ -836,10 +986,6 @@ Node::Ptr FunctionStatement::gen_wat(WasmContext &ctx) {
             return set_error(fmt::format("Class '{}' has no symbol table", leftClass->as_string()));
         }
 
-        auto rightIdentifier = std::dynamic_pointer_cast<Identifier>(m_right);
-        if (!rightIdentifier) {
-            return set_error("Right-hand side of dot expression must be an identifier");
-        }
         if (st.is_builtin(rightIdentifier->get_name())) {
             return set_error(FF("Identifier '{}' has no subsymbol '{}'", leftIdentifier->get_name(), rightIdentifier->get_name()));
         }
@@ -861,6 +1007,10 @@ Node::Ptr FunctionStatement::gen_wat(WasmContext &ctx) {
             std::string fullExpression = fmt::format("{}.{}", leftIdentifier->get_name(), rightIdentifier->get_name());
             return set_error(fmt::format("Identifier '{}' is not found", fullExpression));
         }
+        m_member = memberSymbol;
+        if (m_member->get_stmt_type()) {
+            set_stmt_type(m_member->get_stmt_type());
+        }
         return nullptr;
     }
 
@@ -872,4 +1022,281 @@ Node::Ptr FunctionStatement::gen_wat(WasmContext &ctx) {
         return nullptr;
     }
 
+    /*
+     * Lowering to the IR
+     */
+    namespace {
+    bool leaves_value(const Node::Ptr &stmt, const ir::Builder &b) {
+        if (auto call = std::dynamic_pointer_cast<CallStatement>(stmt)) {
+            auto id = std::dynamic_pointer_cast<Identifier>(call->get_callee());
+            return b.has_result(b.find_func(id->get_name()));
+        }
+        return ! std::dynamic_pointer_cast<Statement>(stmt);
+    }
+
+    /* Emits a statement list, dropping the values of expressions used as statements */
+    Node::Ptr gen_ir_stmt(const Node::Ptr &stmt, ir::Builder &b) {
+        if (auto ret = stmt->gen_ir(b)) {
+            return ret;
+        }
+        if (leaves_value(stmt, b)) {
+            b.op(ir::Opcode::Drop);
+        }
+        return nullptr;
+    }
+
+    Node::Ptr gen_ir_stmts(const Node::Ptr &stmts, ir::Builder &b) {
+        if (! stmts) {
+            return nullptr;
+        }
+        if (! std::dynamic_pointer_cast<StatementList>(stmts)) {
+            return gen_ir_stmt(stmts, b);
+        }
+        for (const auto &stmt : StatementList::statements_of(stmts)) {
+            if (auto ret = gen_ir_stmt(stmt, b)) {
+                return ret;
+            }
+        }
+        return nullptr;
+    }
+
+    /* Conditions are i64 booleans, if wants an i32 */
+    Node::Ptr gen_ir_condition(const Node::Ptr &condition, ir::Builder &b) {
+        if (auto ret = condition->gen_ir(b)) {
+            return ret;
+        }
+        b.op(ir::Opcode::Wrap, ir::Type::I64);
+        return nullptr;
+    }
+    } // namespace
+
+    Node::Ptr Module::gen_ir(ir::Builder &b) {
+        std::vector<std::shared_ptr<FunctionStatement>> funcs;
+        std::vector<std::shared_ptr<LetStatement>> globals;
+
+        for (const auto &stmt : StatementList::statements_of(m_statements)) {
+            if (auto func = std::dynamic_pointer_cast<FunctionStatement>(stmt)) {
+                funcs.push_back(func);
+            }
+            else if (auto let = std::dynamic_pointer_cast<LetStatement>(stmt)) {
+                globals.push_back(let);
+            }
+            else if (! std::dynamic_pointer_cast<ImportStatement>(stmt)
+                    && ! std::dynamic_pointer_cast<ClassStatement>(stmt)) {
+                return stmt->set_error(FF(
+                        "Code generation is not supported for module level {}",
+                        stmt->as_string()));
+            }
+        }
+
+        // declare every function first, so calls may refer to functions defined further down
+        for (const auto &func : funcs) {
+            auto id = std::dynamic_pointer_cast<Identifier>(func->get_name());
+            assert(id);
+            if (b.find_func(id->get_name()) != ir::Builder::npos) {
+                return func->set_error(FF("Function '{}' is already defined", id->get_name()));
+            }
+            b.declare_func(
+                    id->get_name(), func->get_parameter_list().size(), func->has_result());
+        }
+
+        // module level variables become globals, initialized in the order they are defined
+        for (const auto &let : globals) {
+            auto id = std::dynamic_pointer_cast<Identifier>(let->get_identifier());
+            assert(id);
+            if (b.find_global(id->get_name()) != ir::Builder::npos) {
+                return let->set_error(FF("Variable '{}' is already defined", id->get_name()));
+            }
+
+            b.begin_global(id->get_name());
+            if (! let->get_value()) {
+                b.i64_const(0);
+            }
+            else if (auto ret = let->get_value()->gen_ir(b)) {
+                return ret;
+            }
+            b.end_global();
+        }
+
+        for (const auto &func : funcs) {
+            if (Trace::Span span("gen_ir", get_trace_label(func)); auto ret = func->gen_ir(b)) {
+                return ret;
+            }
+        }
+
+        return nullptr;
+    }
+
+    bool FunctionStatement::has_result() const {
+        auto id = std::dynamic_pointer_cast<Identifier>(m_returnType);
+        return id && id->get_name().str() != "Void";
+    }
+
+    std::vector<std::shared_ptr<Parameter>> FunctionStatement::get_parameter_list() const {
+        const auto &items = ParameterList::parameters_of(m_parameters);
+
+        std::vector<std::shared_ptr<Parameter>> retval;
+        retval.reserve(items.size());
+        for (const auto &item : items) {
+            auto param = std::dynamic_pointer_cast<Parameter>(item);
+            assert(param);
+            retval.push_back(param);
+        }
+        return retval;
+    }
+
+    std::shared_ptr<Parameter> FunctionStatement::find_parameter(Symbol name) const {
+        for (const auto &item : ParameterList::parameters_of(m_parameters)) {
+            auto param = std::static_pointer_cast<Parameter>(item);
+            auto id = std::dynamic_pointer_cast<Identifier>(param->get_name());
+            if (id && id->get_name() == name) {
+                return param;
+            }
+        }
+        return nullptr;
+    }
+
+    Node::Ptr FunctionStatement::gen_ir(ir::Builder &b) {
+        auto id = std::dynamic_pointer_cast<Identifier>(m_name);
+        assert(id);
+
+        b.begin_func(b.find_func(id->get_name()));
+        for (const auto &param : get_parameter_list()) {
+            auto param_id = std::dynamic_pointer_cast<Identifier>(param->get_name());
+            assert(param_id);
+            b.add_local(param_id->get_name());
+        }
+
+        if (auto ret = gen_ir_stmts(m_body, b)) {
+            return ret;
+        }
+
+        // the validator has to see that control never falls off the end of a function with a
+        // result, every path of a well-typed one ends in a return. ConstantFolding drops it
+        // again behind a trailing return, so the emitted epilogue is the return alone.
+        if (has_result()) {
+            b.op(ir::Opcode::Unreachable);
+        }
+
+        b.end_func();
+        return nullptr;
+    }
+
+    Node::Ptr CallStatement::gen_ir(ir::Builder &b) {
+        auto id = std::dynamic_pointer_cast<Identifier>(m_callee);
+        auto func = id ? b.find_func(id->get_name()) : ir::Builder::npos;
+        if (func == ir::Builder::npos) {
+            return set_error(FF("Code generation is not supported for call to {}",
+                    m_callee->as_string()));
+        }
+
+        const auto &args = ParameterList::parameters_of(m_arguments);
+        if (args.size() != b.get_num_params(func)) {
+            return set_error(FF("Function '{}' takes {} arguments, {} given", id->get_name(),
+                    b.get_num_params(func), args.size()));
+        }
+
+        for (const auto &arg : args) {
+            // call arguments are parsed as untyped parameters
+            auto param = std::dynamic_pointer_cast<Parameter>(arg);
+            auto value = param ? param->get_name() : arg;
+            if (auto ret = value->gen_ir(b)) {
+                return ret;
+            }
+        }
+
+        b.op(ir::Opcode::Call, func);
+        return nullptr;
+    }
+
+    Node::Ptr ReturnStatement::gen_ir(ir::Builder &b) {
+        if (auto ret = m_expression->gen_ir(b)) {
+            return ret;
+        }
+        if (! b.has_result(b.get_cur_func()) && leaves_value(m_expression, b)) {
+            b.op(ir::Opcode::Drop);
+        }
+        b.op(ir::Opcode::Return);
+        return nullptr;
+    }
+
+    Node::Ptr LetStatement::gen_ir(ir::Builder &b) {
+        auto id = std::dynamic_pointer_cast<Identifier>(m_identifier);
+        assert(id);
+
+        // the value may still refer to an outer variable of the same name
+        if (m_value) {
+            if (auto ret = m_value->gen_ir(b)) {
+                return ret;
+            }
+        }
+
+        auto local = b.add_local(id->get_name());
+        if (m_value) {
+            b.op(ir::Opcode::LocalSet, local);
+        }
+        return nullptr;
+    }
+
+    Node::Ptr AssignmentStatement::gen_ir(ir::Builder &b) {
+        auto id = std::dynamic_pointer_cast<Identifier>(m_left);
+        auto local = id ? b.find_local(id->get_name()) : ir::Builder::npos;
+        auto global = id && local == ir::Builder::npos ? b.find_global(id->get_name())
+                                                       : ir::Builder::npos;
+        if (local == ir::Builder::npos && global == ir::Builder::npos) {
+            return set_error(FF("Code generation is not supported for assignment to {}",
+                    m_left->as_string()));
+        }
+
+        if (auto ret = m_right->gen_ir(b)) {
+            return ret;
+        }
+        if (local != ir::Builder::npos) {
+            b.op(ir::Opcode::LocalSet, local);
+        }
+        else {
+            b.op(ir::Opcode::GlobalSet, global);
+        }
+        return nullptr;
+    }
+
+    Node::Ptr IfStatement::gen_ir(ir::Builder &b) {
+        if (auto ret = gen_ir_condition(m_condition, b)) {
+            return ret;
+        }
+
+        b.block(ir::Opcode::If);
+        if (auto ret = gen_ir_stmts(m_thenBranch, b)) {
+            return ret;
+        }
+        if (m_elseBranch) {
+            b.op(ir::Opcode::Else);
+            if (auto ret = gen_ir_stmts(m_elseBranch, b)) {
+                return ret;
+            }
+        }
+        b.op(ir::Opcode::End);
+        return nullptr;
+    }
+
+    Node::Ptr WhileStatement::gen_ir(ir::Builder &b) {
+        // block $exit, loop $repeat, br_if $exit unless condition, body, br $repeat
+        b.block(ir::Opcode::Block);
+        b.block(ir::Opcode::Loop);
+        if (auto ret = m_condition->gen_ir(b)) {
+            return ret;
+        }
+        b.op(ir::Opcode::Eqz, ir::Type::I64);
+        b.op(ir::Opcode::BrIf, 1);
+
+        if (auto ret = gen_ir_stmts(m_repeatBranch, b)) {
+            return ret;
+        }
+
+        b.op(ir::Opcode::Br, 0);
+        b.op(ir::Opcode::End);
+        b.op(ir::Opcode::End);
+        return nullptr;
+    }
+
 }
\ No newline at end of file
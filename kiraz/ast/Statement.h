@@ -13,6 +13,7 @@ namespace fs = std::filesystem;
 
 namespace ast {
 
+class FunctionStatement;
 class Parameter;
 class ParameterList;
 
@@ -38,7 +39,7 @@ public:
     Node::Ptr add_to_symtab_forward(SymbolTable &st) override;
     Node::Ptr add_to_symtab_ordered(SymbolTable &st) override;
 
-    Node::Ptr gen_wat(WasmContext &ctx) override;
+    Node::Ptr gen_ir(ir::Builder &b) override;
 
     std::string as_string() const override {
     return fmt::format("Module([{}])", m_statements ? m_statements->as_string() : "");
@@ -46,37 +47,40 @@ public:
 
 };
 
+/**
+ * @brief StatementList: A sequence of statements, kept in one contiguous vector. The parser
+ *        appends to it as it goes, so even very long sequences are walked without recursion.
+ */
 class StatementList : public Statement {
 private:
-    Node::Ptr m_first;
-    Node::Ptr m_next;
+    std::vector<Node::Ptr> m_statements;
 
 public:
-    StatementList(Node::Ptr first, Node::Ptr next)
-        : Statement(IDENTIFIER), m_first(first), m_next(next) {}
+    explicit StatementList(Node::Ptr first) : Statement(IDENTIFIER) {
+        assert(first);
+        m_statements.push_back(std::move(first));
+    }
 
     bool is_stmt_list() const override { return true; }
-    
+
     Node::Ptr compute_stmt_type(SymbolTable &st) override;
     Node::Ptr add_to_symtab_forward(SymbolTable &st) override;
     Node::Ptr add_to_symtab_ordered(SymbolTable &st) override;
-    
-    auto get_first() const { return m_first; } 
-    auto get_next() const { return m_next; }
 
-    std::string as_string() const override {
-        std::string result = "";
+    void append(Node::Ptr stmt) {
+        assert(stmt);
+        m_statements.push_back(std::move(stmt));
+    }
 
-        if (m_first) {
-            result += m_first->as_string();
-        }
+    const auto &get_statements() const { return m_statements; }
 
-        if (m_next) {
-            result += ", " + m_next->as_string();
-        }
+    /**
+     * @brief statements_of: Returns the statements of the given node if it is a StatementList,
+     *        otherwise an empty sequence.
+     */
+    static const std::vector<Node::Ptr> &statements_of(const Node::Ptr &node);
 
-        return result;
-    }
+    std::string as_string() const override;
 };
 
 class ImportStatement : public Statement {
@@ -103,11 +107,11 @@ public:
         for (const auto &path : searchPaths) {
             std::string fullPath = path + moduleName + ".ki";
             if (fs::exists(fullPath)) {
-                std::cout << "Found module: " << fullPath << std::endl;
+                std::cerr << "Found module: " << fullPath << std::endl;
                 return fullPath;
             }
         }
-        std::cout << "Module not found: " << moduleName << std::endl;
+        std::cerr << "Module not found: " << moduleName << std::endl;
         return "";
     }
 
@@ -123,6 +127,14 @@ private:
     Node::Ptr m_callee;
     Node::Ptr m_arguments;
 
+    /**
+     * @brief check_call: Checks the arguments against the parameters of the called function and
+     *        takes its return type.
+     * @param name: The callee as written, eg. "io.print"
+     */
+    Node::Ptr check_call(const std::shared_ptr<FunctionStatement> &func, const std::string &name,
+            SymbolTable &st);
+
 public:
     CallStatement(Node::Ptr callee, Node::Ptr arguments)
         : Statement(IDENTIFIER), m_callee(callee), m_arguments(arguments) {}
@@ -132,6 +144,7 @@ public:
     Node::Ptr compute_stmt_type(SymbolTable &st) override;
     Node::Ptr add_to_symtab_forward(SymbolTable &st) override;
     Node::Ptr add_to_symtab_ordered(SymbolTable &st) override;
+    Node::Ptr gen_ir(ir::Builder &b) override;
 
     auto get_callee() const { return m_callee; }
     auto get_arguments() const { return m_arguments; }
@@ -207,8 +220,23 @@ public:
     Node::Ptr add_to_symtab_forward(SymbolTable &st) override;
     Node::Ptr add_to_symtab_ordered(SymbolTable &st) override;
 
-    Node::Ptr gen_wat(WasmContext &ctx) override;
-    
+    Node::Ptr gen_ir(ir::Builder &b) override;
+
+    /**
+     * @brief has_result: Whether the function returns a value, ie. its return type is not Void.
+     */
+    bool has_result() const;
+
+    /**
+     * @brief get_parameter_list: Returns the parameters in declaration order.
+     */
+    std::vector<std::shared_ptr<Parameter>> get_parameter_list() const;
+
+    /**
+     * @brief find_parameter: Returns the parameter with the given name, nullptr if there is none.
+     */
+    std::shared_ptr<Parameter> find_parameter(Symbol name) const;
+
     auto get_name() const { return m_name; }
     auto get_return_type() const { return m_returnType; }
     auto get_parameters() const { return m_parameters; }
@@ -247,6 +275,7 @@ public:
     Node::Ptr compute_stmt_type(SymbolTable &st) override;
     Node::Ptr add_to_symtab_forward(SymbolTable &st) override;
     Node::Ptr add_to_symtab_ordered(SymbolTable &st) override;
+    Node::Ptr gen_ir(ir::Builder &b) override;
     
     auto get_expression() const { return m_expression; }
 
@@ -255,40 +284,44 @@ public:
     }
 };
 
+/**
+ * @brief ParameterList: The parameters of a function or the arguments of a call, in source order.
+ *        Like StatementList it is a flat vector the parser appends to.
+ */
 class ParameterList : public Statement {
 private:
-    Node::Ptr m_first;
-    Node::Ptr m_next;
+    std::vector<Node::Ptr> m_parameters;
     std::shared_ptr<FunctionStatement> m_stmt;
 
 public:
-    ParameterList(Node::Ptr first, Node::Ptr next)
-        : Statement(IDENTIFIER), m_first(first), m_next(next) {}
+    explicit ParameterList(Node::Ptr first) : Statement(IDENTIFIER) {
+        assert(first);
+        m_parameters.push_back(std::move(first));
+    }
     
     bool is_funcarg_list() const override { return true; }
     
     Node::Ptr compute_stmt_type(SymbolTable &st) override;
     Node::Ptr add_to_symtab_forward(SymbolTable &st) override;
     Node::Ptr add_to_symtab_ordered(SymbolTable &st) override;
-    
-    auto get_first() const { return m_first; }
-    auto get_next() const { return m_next; }
+
+    void append(Node::Ptr param) {
+        assert(param);
+        m_parameters.push_back(std::move(param));
+    }
+
+    const auto &get_parameters() const { return m_parameters; }
+
+    /**
+     * @brief parameters_of: Returns the items of the given node if it is a ParameterList,
+     *        otherwise an empty sequence.
+     */
+    static const std::vector<Node::Ptr> &parameters_of(const Node::Ptr &node);
+
     auto get_stmt() const { return m_stmt; }
     void set_stmt(std::shared_ptr<FunctionStatement> stmt) { m_stmt = stmt; }
 
-    std::string as_string() const override {
-        std::string result = "";
-        
-        if (m_first) {
-            result += m_first->as_string();
-        }
-        
-        if (m_next) {
-            result += ", " + m_next->as_string();
-        }
-        
-        return result;
-    }
+    std::string as_string() const override;
 };
 
 class Parameter : public Statement {
@@ -349,38 +382,8 @@ public:
     Node::Ptr compute_stmt_type(SymbolTable &st) override;
     Node::Ptr add_to_symtab_forward(SymbolTable &st) override;
     Node::Ptr add_to_symtab_ordered(SymbolTable &st) override;
+    Node::Ptr gen_ir(ir::Builder &b) override;
 
-    Node::Ptr gen_wat(WasmContext &ctx) override {
-        auto id = std::dynamic_pointer_cast<Identifier>(m_identifier);
-        assert(id);
-        ctx.locals() << "  (local $" << id->get_name() << " i64)\n";
-
-        if (m_value) {
-            m_value->gen_wat(ctx);
-            ctx.body() << "  local.set $" << id->get_name() << "\n";
-        }
-
-        return nullptr;
-    }
-
-    Node::Ptr gen_wat_to_buffer(WasmContext &ctx, std::ostream &buffer) {
-        auto id = std::dynamic_pointer_cast<Identifier>(m_identifier);
-        assert(id);
-
-        // Add local variable declaration to ctx.locals()
-        ctx.locals() << "  (local $" << id->get_name() << " i64)\n";
-
-        // Generate WAT for the initialization value if present
-        if (m_value) {
-            m_value->gen_wat(ctx); // Generate the value's WAT code
-            buffer << "  local.set $" << id->get_name() << "\n"; // Append instruction to the buffer
-        }
-
-        return nullptr;
-    }
-
-
-    
     LetStatement(const Node::Ptr &identifier, const Node::Ptr &type, const Node::Ptr &value)
         : Statement(KW_LET), m_identifier(identifier), m_type(type), m_value(value) {
             assert(identifier);
@@ -430,6 +433,7 @@ public:
     Node::Ptr compute_stmt_type(SymbolTable &st) override;
     Node::Ptr add_to_symtab_forward(SymbolTable &st) override;
     Node::Ptr add_to_symtab_ordered(SymbolTable &st) override;
+    Node::Ptr gen_ir(ir::Builder &b) override;
     
     auto get_left() const { return m_left; }
     auto get_right() const { return m_right; }
@@ -458,31 +462,7 @@ public:
     Node::Ptr compute_stmt_type(SymbolTable &st) override;
     Node::Ptr add_to_symtab_forward(SymbolTable &st) override;
     Node::Ptr add_to_symtab_ordered(SymbolTable &st) override;
-
-    Node::Ptr gen_wat(WasmContext &ctx) override {
-        ctx.body() << "(if \n";
-
-        ctx.body() << "  (condition\n";
-        if (m_condition) {
-            m_condition->gen_wat(ctx);
-        }
-        ctx.body() << "  )\n";
-
-        ctx.body() << "  (then\n";
-        if (m_thenBranch) {
-            m_thenBranch->gen_wat(ctx);
-        }
-        ctx.body() << "  )\n";
-
-        if (m_elseBranch) {
-            ctx.body() << "  (else\n";
-            m_elseBranch->gen_wat(ctx);
-            ctx.body() << "  )\n";
-        }
-
-        ctx.body() << ")\n";
-        return nullptr;
-    }
+    Node::Ptr gen_ir(ir::Builder &b) override;
 
     auto get_condition() const { return m_condition; }
     auto get_then_branch() const { return m_thenBranch; }
@@ -533,6 +513,7 @@ public:
     Node::Ptr compute_stmt_type(SymbolTable &st) override;
     Node::Ptr add_to_symtab_forward(SymbolTable &st) override;
     Node::Ptr add_to_symtab_ordered(SymbolTable &st) override;
+    Node::Ptr gen_ir(ir::Builder &b) override;
     
     auto get_condition() const { return m_condition; }
     auto get_repeat_branch() const { return m_repeatBranch; }
@@ -550,6 +531,7 @@ class OpDot : public Statement {
 private:
     Node::Ptr m_left;
     Node::Ptr m_right;
+    Node::Ptr m_member;
 
 public:
     OpDot(Node::Ptr &left, Node::Ptr &right)
@@ -559,6 +541,11 @@ public:
     auto get_left() const { return m_left; }
     auto get_right() const { return m_right; }
 
+    /**
+     * @brief get_member: Returns the declaration the right hand side names, once checked.
+     */
+    auto get_member() const { return m_member; }
+
     std::string as_string() const override {
         return fmt::format("Dot(l={}, r={})", m_left->as_string(), m_right->as_string());
     }
@@ -0,0 +1,252 @@
+#include <map>
+#include <optional>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include <lexer.hpp>
+#include <main.h>
+
+#include <kiraz/Compiler.h>
+#include <kiraz/WatWriter.h>
+#include <kiraz/ast/Identifier.h>
+#include <kiraz/ir/IR.h>
+
+namespace {
+
+/* Sizes of the synthetic modules, in functions */
+constexpr int64_t SMALL = 10;
+constexpr int64_t MEDIUM = 1000;
+constexpr int64_t LARGE = 20000;
+
+/**
+ * @brief make_module: Returns a module that passes every phase. Each function has a few lets, a
+ *        loop, a branch and a call to the function before it, every 16th function is preceded by
+ *        a class.
+ */
+std::string make_module(size_t num_funcs) {
+    std::string retval = "let scale = 3;\n";
+    for (size_t i = 0; i < num_funcs; ++i) {
+        if (i % 16 == 0) {
+            retval += FF("class C{} {{ let x: Integer64; let y = {}; "
+                         "func get() : Integer64 {{ return {}; }}; }};\n",
+                    i, i, i);
+        }
+        retval += FF("func f{}(a: Integer64, b: Integer64) : Integer64 {{\n"
+                     "    let s = a * {} + b * scale;\n"
+                     "    let n = 0;\n"
+                     "    while (n < 10) {{ s = s + n * 2 - b; n = n + 1; }};\n"
+                     "    if (s > {}) {{ s = s - 1; }} else {{ s = s + (a - b) * (a + b); }};\n"
+                     "    return {};\n"
+                     "}};\n",
+                i, i % 97, i, i ? FF("f{}(s, n)", i - 1) : std::string("s"));
+    }
+    return retval;
+}
+
+const std::string &get_module(int64_t num_funcs) {
+    static std::map<int64_t, std::string> modules;
+    auto &retval = modules[num_funcs];
+    if (retval.empty()) {
+        retval = make_module(num_funcs);
+    }
+    return retval;
+}
+
+/* Figures summed over the iterations, reported per second of timed work */
+struct Rates {
+    size_t num_tokens = 0;
+    size_t num_nodes = 0;
+    size_t num_bytes = 0;
+
+    void add(const CompileStats &stats) {
+        num_tokens += stats.num_tokens;
+        num_nodes += stats.num_nodes;
+    }
+
+    void report(benchmark::State &state) const {
+        using benchmark::Counter;
+        if (num_tokens) {
+            state.counters["tokens/s"] = Counter(double(num_tokens), Counter::kIsRate);
+        }
+        if (num_nodes) {
+            state.counters["nodes/s"] = Counter(double(num_nodes), Counter::kIsRate);
+        }
+        state.SetBytesProcessed(num_bytes);
+    }
+};
+
+/* Parses the module with a fresh compiler, outside of the timed part */
+Node::Ptr prepare(benchmark::State &state, std::optional<Compiler> &compiler,
+        const std::string &code) {
+    state.PauseTiming();
+    compiler.reset();
+    compiler.emplace();
+    auto retval = compiler->compile_module(code);
+    state.ResumeTiming();
+    return retval;
+}
+
+void BM_Lex(benchmark::State &state) {
+    const auto &code = get_module(state.range(0));
+    Compiler compiler;
+    Rates rates;
+    for (auto _ : state) {
+        auto buffer = yy_scan_string(code.data(), compiler.get_scanner());
+        YYSTYPE value;
+        while (yylex(&value, compiler.get_scanner())) {
+        }
+        yy_delete_buffer(buffer, compiler.get_scanner());
+        rates.num_bytes += code.size();
+    }
+    rates.add(compiler.get_stats());
+    rates.report(state);
+}
+
+void BM_Parse(benchmark::State &state) {
+    const auto &code = get_module(state.range(0));
+    std::optional<Compiler> compiler;
+    Rates rates;
+    for (auto _ : state) {
+        state.PauseTiming();
+        compiler.reset();
+        compiler.emplace();
+        state.ResumeTiming();
+
+        benchmark::DoNotOptimize(compiler->compile_module(code));
+        rates.add(compiler->get_stats());
+        rates.num_bytes += code.size();
+    }
+    rates.report(state);
+}
+
+void BM_SymbolTableLookup(benchmark::State &state) {
+    Compiler compiler;
+    auto &names = SymbolTable::get_names();
+    SymbolTable st(ScopeType::Module);
+
+    std::vector<Symbol> symbols;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        symbols.push_back(names.intern(FF("s{}", i)));
+        st.add_symbol(symbols.back(), Node::make<ast::Identifier>(symbols.back()));
+    }
+
+    // nested scopes with bindings of their own, as inside a method
+    auto enter = [&](size_t depth) {
+        auto stmt = Node::make<ast::Identifier>(names.intern(FF("scope{}", depth)));
+        stmt->set_cur_symtab(st.get_cur_symtab());
+        auto retval = st.enter_scope(ScopeType::Func, stmt);
+        st.add_symbol(FF("local{}", depth), stmt);
+        return retval;
+    };
+    auto scope0 = enter(0);
+    auto scope1 = enter(1);
+    auto scope2 = enter(2);
+
+    size_t index = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(st.lookup(symbols[index]));
+        index = index + 1 == symbols.size() ? 0 : index + 1;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_EnterScope(benchmark::State &state) {
+    Compiler compiler;
+    auto &names = SymbolTable::get_names();
+    SymbolTable st(ScopeType::Module);
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        auto name = names.intern(FF("f{}", i));
+        st.add_symbol(name, Node::make<ast::Identifier>(name));
+    }
+
+    auto stmt = Node::make<ast::Identifier>(names.intern("func"));
+    stmt->set_cur_symtab(st.get_cur_symtab());
+    auto local = names.intern("x");
+    for (auto _ : state) {
+        auto scope = st.enter_scope(ScopeType::Func, stmt);
+        st.add_symbol(local, stmt);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_ComputeStmtType(benchmark::State &state) {
+    const auto &code = get_module(state.range(0));
+    std::optional<Compiler> compiler;
+    for (auto _ : state) {
+        auto root = prepare(state, compiler, code);
+        SymbolTable st(ScopeType::Module);
+        if (root->compute_stmt_type(st)) {
+            state.SkipWithError("the module does not check");
+            break;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_GenWat(benchmark::State &state) {
+    const auto &code = get_module(state.range(0));
+    std::optional<Compiler> compiler;
+    Rates rates;
+    for (auto _ : state) {
+        state.PauseTiming();
+        compiler.reset();
+        compiler.emplace();
+        auto root = compiler->compile_module(code);
+        SymbolTable st(ScopeType::Module);
+        if (root->compute_stmt_type(st)) {
+            state.SkipWithError("the module does not check");
+            break;
+        }
+        state.ResumeTiming();
+
+        // lowering, the optimizer passes and the writer make up code generation
+        ir::Module module;
+        ir::Builder builder(module);
+        if (root->gen_ir(builder)) {
+            state.SkipWithError("the module does not lower");
+            break;
+        }
+        compiler->get_passes().run(module);
+        OutputBuffer out;
+        WatWriter::write(module, out);
+        rates.num_bytes += out.size();
+    }
+    rates.report(state);
+}
+
+void BM_CompileString(benchmark::State &state) {
+    const auto &code = get_module(state.range(0));
+    std::optional<Compiler> compiler;
+    Rates rates;
+    for (auto _ : state) {
+        state.PauseTiming();
+        compiler.reset();
+        compiler.emplace();
+        state.ResumeTiming();
+
+        if (compiler->compile_string(code) != 0) {
+            state.SkipWithError(compiler->get_error().data());
+            break;
+        }
+        rates.add(compiler->get_stats());
+        rates.num_bytes += code.size();
+    }
+    rates.report(state);
+}
+
+} // namespace
+
+BENCHMARK(BM_Lex)->Arg(MEDIUM)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Parse)->Arg(MEDIUM)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SymbolTableLookup)->Arg(16)->Arg(1024)->Arg(65536);
+BENCHMARK(BM_EnterScope)->Arg(16)->Arg(65536);
+BENCHMARK(BM_ComputeStmtType)->Arg(MEDIUM)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_GenWat)->Arg(MEDIUM)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CompileString)
+        ->Arg(SMALL)
+        ->Arg(MEDIUM)
+        ->Arg(LARGE)
+        ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,304 @@
+/*
+ * fuzz_compile: Searches for inputs whose compilation costs grow faster than the inputs do, eg.
+ * symbol table lookups that get slower with every scope, parent class walks in OpDot or
+ * as_string calls on ever larger subtrees. Crashes are not the objective, cost is: an input is
+ * charged the time and the work its compilation took, the latter counted by CompileStats and
+ * deterministic, divided by its size.
+ *
+ * Built with -fsanitize=fuzzer (KIRAZ_FUZZ), libFuzzer drives it. Every doubling of the cost per
+ * byte counts as new coverage, so the fuzzer keeps the inputs that climb, and inputs over the
+ * budget are saved to the directory named by KIRAZ_FUZZ_SAVE_DIR, "slow" by default.
+ *
+ * Built without, it replays the given files and directories, eg. the seeds in kiraz/fuzz/corpus,
+ * and fails if any costs more than the budget. `fuzz_compile --minimize in.ki out.ki` shrinks a
+ * saved input to a small one that is still over the budget, to be added to the corpus once the
+ * cause is fixed.
+ *
+ * The budget defaults to DEFAULT_WORK_PER_BYTE and DEFAULT_NS_PER_BYTE, KIRAZ_FUZZ_WORK_PER_BYTE
+ * and KIRAZ_FUZZ_NS_PER_BYTE override them.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <kiraz/CompileStats.h>
+#include <kiraz/Compiler.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+/* Work units per byte, a linear front end stays in the low single digits */
+constexpr double DEFAULT_WORK_PER_BYTE = 16;
+
+/* Generous, instrumented builds are several times slower than release ones */
+constexpr double DEFAULT_NS_PER_BYTE = 5000;
+
+/* Shorter inputs are charged as if they were this long, their fixed costs dominate */
+constexpr size_t MIN_CHARGED_SIZE = 256;
+
+struct Cost {
+    double ns = 0;
+    double work = 0;
+};
+
+struct Budget {
+    double work_per_byte = DEFAULT_WORK_PER_BYTE;
+    double ns_per_byte = DEFAULT_NS_PER_BYTE;
+
+    static const Budget &get() {
+        static const Budget retval = [] {
+            Budget budget;
+            if (auto value = std::getenv("KIRAZ_FUZZ_WORK_PER_BYTE")) {
+                budget.work_per_byte = std::atof(value);
+            }
+            if (auto value = std::getenv("KIRAZ_FUZZ_NS_PER_BYTE")) {
+                budget.ns_per_byte = std::atof(value);
+            }
+            return budget;
+        }();
+        return retval;
+    }
+};
+
+/**
+ * @brief compile: Compiles the given source with a fresh compiler and returns what it took.
+ *        Work is a weighted sum of the counters, arena bytes are counted per node sized chunk.
+ */
+Cost compile(const std::string &source) {
+    using Clock = std::chrono::steady_clock;
+    using Phase = CompileStats::Phase;
+
+    Cost retval;
+    auto begin = Clock::now();
+    {
+        Compiler compiler;
+        compiler.compile_string(source);
+
+        const auto &stats = compiler.get_stats();
+        uint64_t arena_bytes = 0;
+        for (size_t i = size_t(Phase::None) + 1; i < size_t(Phase::Count); ++i) {
+            arena_bytes += stats.get(Phase(i)).arena_bytes;
+        }
+        retval.work = double(stats.num_tokens + stats.num_nodes + stats.num_scopes
+                              + stats.num_lookups)
+                + double(arena_bytes) / 64;
+    }
+    retval.ns = std::chrono::duration<double, std::nano>(Clock::now() - begin).count();
+    return retval;
+}
+
+/**
+ * @brief measure: Returns the cost of the given source beyond that of an empty one, the fastest
+ *        of the given number of runs.
+ */
+Cost measure(const std::string &source, size_t num_runs = 1) {
+    static const Cost empty = [] {
+        // the first compilation also pays for warming up, eg. decoding the prelude
+        compile("");
+        return compile("");
+    }();
+
+    auto retval = compile(source);
+    for (size_t run = 1; run < num_runs; ++run) {
+        retval.ns = std::min(retval.ns, compile(source).ns);
+    }
+    retval.ns = std::max(retval.ns - empty.ns, 0.0);
+    retval.work = std::max(retval.work - empty.work, 0.0);
+    return retval;
+}
+
+double get_charged_size(const std::string &source) {
+    return double(std::max(source.size(), MIN_CHARGED_SIZE));
+}
+
+bool is_over_budget(const std::string &source, const Cost &cost) {
+    const auto &budget = Budget::get();
+    auto size = get_charged_size(source);
+    return cost.work / size > budget.work_per_byte || cost.ns / size > budget.ns_per_byte;
+}
+
+std::string describe(const std::string &source, const Cost &cost) {
+    auto size = get_charged_size(source);
+    return FF("{} bytes, {:.1f} work/byte, {:.0f} ns/byte", source.size(), cost.work / size,
+            cost.ns / size);
+}
+
+bool write_file(const fs::path &path, const std::string &source) {
+    std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    file << source;
+    return bool(file);
+}
+
+} // namespace
+
+#ifdef KIRAZ_LIBFUZZER
+
+namespace {
+
+/* libFuzzer treats every counter in this section that turns nonzero as a new feature */
+#ifdef __linux__
+__attribute__((used, section("__libfuzzer_extra_counters")))
+#endif
+uint8_t s_cost_features[2][64];
+
+/* FNV-1a, names the saved inputs */
+uint64_t hash(std::string_view text) {
+    uint64_t retval = 0xcbf29ce484222325;
+    for (auto c : text) {
+        retval = (retval ^ uint8_t(c)) * 0x100000001b3;
+    }
+    return retval;
+}
+
+/* Two buckets per doubling */
+size_t get_bucket(double per_byte) {
+    if (per_byte < 1) {
+        return 0;
+    }
+    return std::min(size_t(std::log2(per_byte) * 2) + 1, std::size(s_cost_features[0]) - 1);
+}
+
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    std::string source(reinterpret_cast<const char *>(data), size);
+    auto cost = measure(source);
+
+    auto charged_size = get_charged_size(source);
+    s_cost_features[0][get_bucket(cost.work / charged_size)] = 1;
+    s_cost_features[1][get_bucket(cost.ns / charged_size)] = 1;
+
+    // time is noisy, so a slow looking input has to be slow twice
+    if (! is_over_budget(source, cost) || ! is_over_budget(source, cost = measure(source, 3))) {
+        return 0;
+    }
+
+    auto dir = fs::path(std::getenv("KIRAZ_FUZZ_SAVE_DIR") ? std::getenv("KIRAZ_FUZZ_SAVE_DIR")
+                                                           : "slow");
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+    auto path = dir / FF("{:016x}.ki", hash(source));
+    if (! fs::exists(path) && write_file(path, source)) {
+        fmt::print(stderr, "fuzz_compile: saved {}, {}\n", path.string(), describe(source, cost));
+    }
+    return 0;
+}
+
+#else
+
+namespace {
+
+bool read_file(const fs::path &path, std::string &source) {
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (! file.is_open()) {
+        return false;
+    }
+    source.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+/**
+ * @brief minimize: Removes ever smaller chunks of the source as long as what is left stays over
+ *        the budget, the smallest chunks being single bytes.
+ */
+std::string minimize(std::string source) {
+    for (size_t chunk = source.size() / 2; chunk > 0; chunk /= 2) {
+        for (size_t offset = 0; offset < source.size();) {
+            auto candidate = source;
+            candidate.erase(offset, chunk);
+            if (is_over_budget(candidate, measure(candidate, 3))) {
+                source = std::move(candidate);
+            }
+            else {
+                offset += chunk;
+            }
+        }
+    }
+    return source;
+}
+
+int replay(const std::vector<fs::path> &paths) {
+    std::vector<fs::path> files;
+    for (const auto &path : paths) {
+        if (fs::is_directory(path)) {
+            for (const auto &item : fs::directory_iterator(path)) {
+                if (item.is_regular_file()) {
+                    files.push_back(item.path());
+                }
+            }
+        }
+        else {
+            files.push_back(path);
+        }
+    }
+    std::sort(files.begin(), files.end());
+
+    size_t num_over = 0;
+    for (const auto &file : files) {
+        std::string source;
+        if (! read_file(file, source)) {
+            fmt::print(stderr, "Error: Unable to read {}\n", file.string());
+            return 1;
+        }
+
+        auto cost = measure(source, 3);
+        bool is_over = is_over_budget(source, cost);
+        fmt::print("{}: {}{}\n", file.filename().string(), describe(source, cost),
+                is_over ? ", over budget" : "");
+        num_over += is_over;
+    }
+
+    const auto &budget = Budget::get();
+    fmt::print("{} of {} inputs over the budget of {} work/byte and {} ns/byte\n", num_over,
+            files.size(), budget.work_per_byte, budget.ns_per_byte);
+    return num_over ? 1 : 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    if (argc == 4 && std::string_view(argv[1]) == "--minimize") {
+        std::string source;
+        if (! read_file(argv[2], source)) {
+            fmt::print(stderr, "Error: Unable to read {}\n", argv[2]);
+            return 1;
+        }
+        if (! is_over_budget(source, measure(source, 3))) {
+            fmt::print(stderr, "Error: {} is within the budget, nothing to minimize\n", argv[2]);
+            return 1;
+        }
+
+        auto minimized = minimize(source);
+        if (! write_file(argv[3], minimized)) {
+            fmt::print(stderr, "Error: Unable to write {}\n", argv[3]);
+            return 1;
+        }
+        fmt::print("{}: {}\n", argv[3], describe(minimized, measure(minimized, 3)));
+        return 0;
+    }
+
+    if (argc < 2 || std::string_view(argv[1]).starts_with("-")) {
+        fmt::print(stderr,
+                "Usage: {} [file.ki | dir] ...   Fails if an input is over the budget\n"
+                "       {} --minimize [in.ki] [out.ki]   Shrinks an input over the budget\n",
+                argv[0], argv[0]);
+        return 1;
+    }
+
+    return replay(std::vector<fs::path>(argv + 1, argv + argc));
+}
+
+#endif
@@ -0,0 +1,508 @@
+
+#include "ConstantFolding.h"
+
+#include <cassert>
+#include <limits>
+
+namespace ir {
+
+namespace {
+/* A value on the operand stack, known ones were pushed by the const instruction at pos */
+struct Value {
+    bool known = false;
+    int64_t value = 0;
+    size_t pos = 0;
+};
+
+/* Brings a computed value into the range of its type, i32 values are kept sign extended */
+int64_t normalize(Type type, uint64_t value) {
+    return type == Type::I32 ? int64_t(int32_t(uint32_t(value))) : int64_t(value);
+}
+
+bool is_binary(Opcode op) {
+    switch (op) {
+    case Opcode::Eq:
+    case Opcode::LtS:
+    case Opcode::GtS:
+    case Opcode::LeS:
+    case Opcode::GeS:
+    case Opcode::Add:
+    case Opcode::Sub:
+    case Opcode::Mul:
+    case Opcode::DivS:
+    case Opcode::And:
+    case Opcode::Or:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief eval_binary: Computes the result of a binary operation on two constants.
+ * @return false if the operation traps at run time and has to be kept
+ */
+bool eval_binary(const Instr &instr, int64_t l, int64_t r, Instr &retval) {
+    auto type = instr.type;
+    auto ul = uint64_t(l), ur = uint64_t(r);
+    auto min = type == Type::I32 ? std::numeric_limits<int32_t>::min()
+                                 : std::numeric_limits<int64_t>::min();
+
+    retval = {Opcode::Const, type, 0};
+    switch (instr.op) {
+    case Opcode::Eq:
+        retval = {Opcode::Const, Type::I32, l == r};
+        return true;
+    case Opcode::LtS:
+        retval = {Opcode::Const, Type::I32, l < r};
+        return true;
+    case Opcode::GtS:
+        retval = {Opcode::Const, Type::I32, l > r};
+        return true;
+    case Opcode::LeS:
+        retval = {Opcode::Const, Type::I32, l <= r};
+        return true;
+    case Opcode::GeS:
+        retval = {Opcode::Const, Type::I32, l >= r};
+        return true;
+    case Opcode::Add:
+        retval.imm = normalize(type, ul + ur);
+        return true;
+    case Opcode::Sub:
+        retval.imm = normalize(type, ul - ur);
+        return true;
+    case Opcode::Mul:
+        retval.imm = normalize(type, ul * ur);
+        return true;
+    case Opcode::DivS:
+        if (r == 0 || (l == min && r == -1)) {
+            return false;
+        }
+        retval.imm = l / r;
+        return true;
+    case Opcode::And:
+        retval.imm = l & r;
+        return true;
+    case Opcode::Or:
+        retval.imm = l | r;
+        return true;
+    default:
+        assert(false);
+        return false;
+    }
+}
+
+/**
+ * @brief find_else_or_end: Returns the index of the else or end that closes the block the
+ *        instruction at start is in, or the size of the code if that is the function body.
+ */
+size_t find_else_or_end(const std::vector<Instr> &code, size_t start) {
+    size_t depth = 0;
+    for (auto i = start; i < code.size(); ++i) {
+        switch (code[i].op) {
+        case Opcode::Block:
+        case Opcode::Loop:
+        case Opcode::If:
+            ++depth;
+            break;
+        case Opcode::Else:
+            if (depth == 0) {
+                return i;
+            }
+            break;
+        case Opcode::End:
+            if (depth == 0) {
+                return i;
+            }
+            --depth;
+            break;
+        default:
+            break;
+        }
+    }
+    return code.size();
+}
+} // namespace
+
+void ConstantFolding::run(Module &module) {
+    m_global_is_const.assign(module.globals.size(), true);
+    for (const auto &func : module.funcs) {
+        for (const auto &instr : func.body) {
+            if (instr.op == Opcode::GlobalSet) {
+                m_global_is_const[instr.imm] = false;
+            }
+        }
+    }
+
+    // initializers may read the globals defined before them, fold those first
+    for (auto &global : module.globals) {
+        Function init;
+        init.body = std::move(global.init);
+        fold(module, init);
+        global.init = std::move(init.body);
+    }
+
+    // unwrapping a block can leave dead code at the level of its parent, fold again then
+    for (auto &func : module.funcs) {
+        do {
+            fold(module, func);
+        } while (remove_unused_blocks(func));
+        remove_unused_locals(func);
+    }
+    module.remove_unused_globals();
+}
+
+void ConstantFolding::fold(const Module &module, Function &func) const {
+    const auto &in = func.body;
+    std::vector<Instr> out;
+    out.reserve(in.size());
+
+    // only locals assigned once can take the value of that assignment everywhere
+    std::vector<uint32_t> num_sets(func.locals.size());
+    for (const auto &instr : in) {
+        if (instr.op == Opcode::LocalSet) {
+            ++num_sets[instr.imm];
+        }
+    }
+    std::vector<bool> is_read(func.locals.size());
+    std::vector<bool> is_const(func.locals.size());
+    std::vector<int64_t> local_values(func.locals.size());
+
+    struct Frame {
+        size_t height;
+        bool skip_else;
+    };
+    std::vector<Frame> frames;
+    std::vector<Value> stack;
+
+    auto push_const = [&](Type type, int64_t value) {
+        stack.push_back({true, value, out.size()});
+        out.push_back({Opcode::Const, type, value});
+    };
+    auto push_unknown = [&](const Instr &instr) {
+        stack.push_back({});
+        out.push_back(instr);
+    };
+    auto pop = [&]() {
+        assert(! stack.empty());
+        auto retval = stack.back();
+        stack.pop_back();
+        return retval;
+    };
+    // a known value can only be taken back while its const is the last instruction emitted
+    auto is_last = [&](const Value &value, size_t distance = 1) {
+        return value.known && value.pos + distance == out.size();
+    };
+    auto height = [&]() { return frames.empty() ? 0 : frames.back().height; };
+
+    for (size_t i = 0; i < in.size(); ++i) {
+        const auto &instr = in[i];
+
+        switch (instr.op) {
+        case Opcode::Const:
+            push_const(instr.type, instr.imm);
+            break;
+
+        case Opcode::LocalGet:
+            is_read[instr.imm] = true;
+            if (is_const[instr.imm]) {
+                push_const(Type::I64, local_values[instr.imm]);
+            }
+            else {
+                push_unknown(instr);
+            }
+            break;
+
+        case Opcode::LocalSet: {
+            // an assignment outside of any block runs before everything that follows it
+            auto value = pop();
+            if (is_last(value) && instr.imm >= func.num_params && num_sets[instr.imm] == 1
+                    && frames.empty() && ! is_read[instr.imm]) {
+                out.pop_back();
+                is_const[instr.imm] = true;
+                local_values[instr.imm] = value.value;
+            }
+            else {
+                out.push_back(instr);
+            }
+            break;
+        }
+
+        case Opcode::GlobalGet:
+            if (m_global_is_const[instr.imm] && module.globals[instr.imm].has_const_init()) {
+                push_const(Type::I64, module.globals[instr.imm].init[0].imm);
+            }
+            else {
+                push_unknown(instr);
+            }
+            break;
+
+        case Opcode::GlobalSet:
+            pop();
+            out.push_back(instr);
+            break;
+
+        case Opcode::Drop:
+            if (is_last(pop())) {
+                out.pop_back();
+            }
+            else {
+                out.push_back(instr);
+            }
+            break;
+
+        case Opcode::Eqz:
+        case Opcode::Wrap:
+        case Opcode::ExtendU: {
+            auto operand = pop();
+
+            // a comparison result widened only to be narrowed or tested again can stay an i32
+            if (instr.op != Opcode::ExtendU && ! out.empty() && out.back().op == Opcode::ExtendU) {
+                out.pop_back();
+                if (instr.op == Opcode::Eqz) {
+                    out.push_back({Opcode::Eqz, Type::I32});
+                }
+                stack.push_back({});
+                break;
+            }
+            if (! is_last(operand)) {
+                push_unknown(instr);
+                break;
+            }
+            out.pop_back();
+            if (instr.op == Opcode::Eqz) {
+                push_const(Type::I32, operand.value == 0);
+            }
+            else if (instr.op == Opcode::Wrap) {
+                push_const(Type::I32, normalize(Type::I32, operand.value));
+            }
+            else {
+                push_const(Type::I64, uint32_t(operand.value));
+            }
+            break;
+        }
+
+        case Opcode::Call: {
+            const auto &callee = module.funcs[instr.imm];
+            assert(stack.size() >= callee.num_params);
+            stack.resize(stack.size() - callee.num_params);
+            if (callee.has_result) {
+                push_unknown(instr);
+            }
+            else {
+                out.push_back(instr);
+            }
+            break;
+        }
+
+        case Opcode::Block:
+        case Opcode::Loop:
+            frames.push_back({stack.size(), false});
+            out.push_back(instr);
+            break;
+
+        case Opcode::If: {
+            auto condition = pop();
+            if (! is_last(condition)) {
+                frames.push_back({stack.size(), false});
+                out.push_back(instr);
+                break;
+            }
+            out.pop_back();
+
+            // the taken arm stays in a plain block, so branch depths inside it do not change
+            if (condition.value) {
+                frames.push_back({stack.size(), true});
+                out.push_back({Opcode::Block, instr.type});
+                break;
+            }
+
+            auto j = find_else_or_end(in, i + 1);
+            assert(j < in.size());
+            if (in[j].op == Opcode::Else) {
+                frames.push_back({stack.size(), false});
+                out.push_back({Opcode::Block, instr.type});
+            }
+            i = j;
+            break;
+        }
+
+        case Opcode::Else:
+            assert(! frames.empty());
+            stack.resize(frames.back().height);
+            if (frames.back().skip_else) {
+                i = find_else_or_end(in, i + 1) - 1;
+            }
+            else {
+                out.push_back(instr);
+            }
+            break;
+
+        case Opcode::End:
+            assert(! frames.empty());
+            stack.resize(frames.back().height);
+            frames.pop_back();
+            out.push_back(instr);
+            break;
+
+        case Opcode::BrIf: {
+            auto condition = pop();
+            if (! is_last(condition)) {
+                out.push_back(instr);
+                break;
+            }
+            out.pop_back();
+            if (! condition.value) {
+                break;
+            }
+            out.push_back({Opcode::Br, Type::Void, instr.imm});
+            stack.resize(height());
+            i = find_else_or_end(in, i + 1) - 1;
+            break;
+        }
+
+        case Opcode::Br:
+        case Opcode::Return:
+        case Opcode::Unreachable:
+            // nothing after these runs before the end of the enclosing block
+            out.push_back(instr);
+            stack.resize(height());
+            i = find_else_or_end(in, i + 1) - 1;
+            break;
+
+        default: {
+            assert(is_binary(instr.op));
+            auto r = pop();
+            auto l = pop();
+            Instr result;
+            if (is_last(r) && is_last(l, 2) && eval_binary(instr, l.value, r.value, result)) {
+                out.resize(out.size() - 2);
+                push_const(result.type, result.imm);
+            }
+            else {
+                push_unknown(instr);
+            }
+            break;
+        }
+        }
+    }
+    assert(frames.empty());
+
+    func.body = std::move(out);
+}
+
+bool ConstantFolding::remove_unused_blocks(Function &func) {
+    auto &code = func.body;
+    std::vector<bool> removed(code.size());
+    bool changed = false;
+
+    // find the blocks and loops no branch refers to, a loop nothing continues runs only once
+    struct Frame {
+        size_t begin;
+        bool is_target = false;
+    };
+    std::vector<Frame> frames;
+    for (size_t i = 0; i < code.size(); ++i) {
+        const auto &instr = code[i];
+        switch (instr.op) {
+        case Opcode::Block:
+        case Opcode::Loop:
+        case Opcode::If:
+            frames.push_back({i});
+            break;
+        case Opcode::Br:
+        case Opcode::BrIf:
+            // a branch to the end of the block it is the last instruction of falls through anyway
+            if (instr.op == Opcode::Br && instr.imm == 0 && i + 1 < code.size()
+                    && code[i + 1].op == Opcode::End
+                    && code[frames.back().begin].op == Opcode::Block) {
+                removed[i] = changed = true;
+            }
+            else if (size_t(instr.imm) < frames.size()) {
+                frames[frames.size() - 1 - instr.imm].is_target = true;
+            }
+            break;
+        case Opcode::End: {
+            auto frame = frames.back();
+            frames.pop_back();
+            if (code[frame.begin].op != Opcode::If && ! frame.is_target) {
+                removed[frame.begin] = removed[i] = changed = true;
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    if (! changed) {
+        return false;
+    }
+
+    // branches out of a removed block now cross one level less
+    std::vector<bool> frame_removed;
+    size_t num_kept = 0;
+    for (size_t i = 0; i < code.size(); ++i) {
+        auto instr = code[i];
+        switch (instr.op) {
+        case Opcode::Block:
+        case Opcode::Loop:
+        case Opcode::If:
+            frame_removed.push_back(removed[i]);
+            break;
+        case Opcode::End:
+            frame_removed.pop_back();
+            break;
+        case Opcode::Br:
+        case Opcode::BrIf: {
+            auto depth = instr.imm;
+            for (int64_t level = 0; level < depth && size_t(level) < frame_removed.size();
+                    ++level) {
+                if (frame_removed[frame_removed.size() - 1 - level]) {
+                    --instr.imm;
+                }
+            }
+            break;
+        }
+        default:
+            break;
+        }
+        if (! removed[i]) {
+            code[num_kept++] = instr;
+        }
+    }
+    code.resize(num_kept);
+    return true;
+}
+
+void ConstantFolding::remove_unused_locals(Function &func) {
+    std::vector<uint32_t> index(func.locals.size(), 0);
+    for (const auto &instr : func.body) {
+        if (instr.op == Opcode::LocalGet || instr.op == Opcode::LocalSet) {
+            index[instr.imm] = 1;
+        }
+    }
+
+    // parameters are part of the signature, only declared locals can go
+    uint32_t num_kept = func.num_params;
+    for (uint32_t i = 0; i < func.num_params; ++i) {
+        index[i] = i;
+    }
+    for (auto i = func.num_params; i < func.locals.size(); ++i) {
+        if (index[i]) {
+            index[i] = num_kept;
+            func.locals[num_kept++] = func.locals[i];
+        }
+    }
+    if (num_kept == func.locals.size()) {
+        return;
+    }
+    func.locals.resize(num_kept);
+
+    for (auto &instr : func.body) {
+        if (instr.op == Opcode::LocalGet || instr.op == Opcode::LocalSet) {
+            instr.imm = index[instr.imm];
+        }
+    }
+}
+
+} // namespace ir
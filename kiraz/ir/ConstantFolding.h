@@ -0,0 +1,30 @@
+#ifndef KIRAZ_IR_CONSTANTFOLDING_H
+#define KIRAZ_IR_CONSTANTFOLDING_H
+
+#include <kiraz/ir/PassManager.h>
+
+namespace ir {
+
+/**
+ * @brief ConstantFolding: Evaluates operations on constants at compile time and propagates the
+ *        values of locals that are assigned a constant exactly once and of globals that are never
+ *        assigned. Branches on constant conditions are resolved, code after an unconditional
+ *        branch is dropped, and blocks, locals and globals left without references are removed.
+ */
+class ConstantFolding : public Pass {
+public:
+    const char *get_name() const override { return "const-fold"; }
+    void run(Module &module) override;
+
+private:
+    void fold(const Module &module, Function &func) const;
+    static bool remove_unused_blocks(Function &func);
+    static void remove_unused_locals(Function &func);
+
+    /* Whether each global is never assigned, indexed like the globals */
+    std::vector<bool> m_global_is_const;
+};
+
+} // namespace ir
+
+#endif // KIRAZ_IR_CONSTANTFOLDING_H
@@ -0,0 +1,57 @@
+
+#include "DeadCodeElimination.h"
+
+#include <cassert>
+#include <limits>
+
+namespace ir {
+
+void DeadCodeElimination::run(Module &module) {
+    constexpr auto unreachable = std::numeric_limits<uint32_t>::max();
+
+    // walk the call graph from the exports, every reached function gets index 0 for now
+    std::vector<uint32_t> index(module.funcs.size(), unreachable);
+    std::vector<uint32_t> pending;
+    for (uint32_t i = 0; i < module.funcs.size(); ++i) {
+        if (module.funcs[i].exported) {
+            index[i] = 0;
+            pending.push_back(i);
+        }
+    }
+    while (! pending.empty()) {
+        auto func = pending.back();
+        pending.pop_back();
+        for (const auto &instr : module.funcs[func].body) {
+            if (instr.op == Opcode::Call && index[instr.imm] == unreachable) {
+                index[instr.imm] = 0;
+                pending.push_back(instr.imm);
+            }
+        }
+    }
+
+    uint32_t num_kept = 0;
+    for (uint32_t i = 0; i < module.funcs.size(); ++i) {
+        if (index[i] != unreachable) {
+            if (i != num_kept) {
+                module.funcs[num_kept] = std::move(module.funcs[i]);
+            }
+            index[i] = num_kept++;
+        }
+    }
+    if (num_kept == module.funcs.size()) {
+        return;
+    }
+    module.funcs.resize(num_kept);
+
+    for (auto &func : module.funcs) {
+        for (auto &instr : func.body) {
+            if (instr.op == Opcode::Call) {
+                assert(index[instr.imm] != unreachable);
+                instr.imm = index[instr.imm];
+            }
+        }
+    }
+    module.remove_unused_globals();
+}
+
+} // namespace ir
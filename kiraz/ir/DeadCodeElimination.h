@@ -0,0 +1,25 @@
+#ifndef KIRAZ_IR_DEADCODEELIMINATION_H
+#define KIRAZ_IR_DEADCODEELIMINATION_H
+
+#include <kiraz/ir/PassManager.h>
+
+namespace ir {
+
+/**
+ * @brief DeadCodeElimination: Removes the functions that no exported function reaches through
+ *        calls, then the globals only those functions used.
+ *
+ *        Only functions and globals are pruned, as the IR holds nothing else: lowering skips
+ *        classes and their methods, and an import only brings declarations, so neither the
+ *        classes of a module nor those of the io prelude reach the output, used or not. Methods
+ *        lowered as functions would be pruned like any other function.
+ */
+class DeadCodeElimination : public Pass {
+public:
+    const char *get_name() const override { return "dce"; }
+    void run(Module &module) override;
+};
+
+} // namespace ir
+
+#endif // KIRAZ_IR_DEADCODEELIMINATION_H
@@ -0,0 +1,207 @@
+
+#include "IR.h"
+
+#include <cassert>
+#include <limits>
+
+namespace ir {
+
+const char *get_name(Opcode op) {
+    switch (op) {
+    case Opcode::Unreachable:
+        return "unreachable";
+    case Opcode::Block:
+        return "block";
+    case Opcode::Loop:
+        return "loop";
+    case Opcode::If:
+        return "if";
+    case Opcode::Else:
+        return "else";
+    case Opcode::End:
+        return "end";
+    case Opcode::Br:
+        return "br";
+    case Opcode::BrIf:
+        return "br_if";
+    case Opcode::Return:
+        return "return";
+    case Opcode::Call:
+        return "call";
+    case Opcode::Drop:
+        return "drop";
+    case Opcode::LocalGet:
+        return "local.get";
+    case Opcode::LocalSet:
+        return "local.set";
+    case Opcode::GlobalGet:
+        return "global.get";
+    case Opcode::GlobalSet:
+        return "global.set";
+    case Opcode::Const:
+        return "const";
+    case Opcode::Eqz:
+        return "eqz";
+    case Opcode::Eq:
+        return "eq";
+    case Opcode::LtS:
+        return "lt_s";
+    case Opcode::GtS:
+        return "gt_s";
+    case Opcode::LeS:
+        return "le_s";
+    case Opcode::GeS:
+        return "ge_s";
+    case Opcode::Add:
+        return "add";
+    case Opcode::Sub:
+        return "sub";
+    case Opcode::Mul:
+        return "mul";
+    case Opcode::DivS:
+        return "div_s";
+    case Opcode::And:
+        return "and";
+    case Opcode::Or:
+        return "or";
+    case Opcode::Wrap:
+        return "wrap_i64";
+    case Opcode::ExtendU:
+        return "extend_i32_u";
+    }
+
+    assert(false);
+    return "";
+}
+
+size_t Module::get_num_instrs() const {
+    size_t retval = 0;
+    for (const auto &func : funcs) {
+        retval += func.body.size();
+    }
+    return retval;
+}
+
+void Module::remove_unused_globals() {
+    constexpr auto unused = std::numeric_limits<uint32_t>::max();
+
+    // a kept global keeps the globals its initial value is computed from
+    std::vector<uint32_t> index(globals.size(), unused);
+    std::vector<uint32_t> pending;
+    auto mark = [&](const std::vector<Instr> &code) {
+        for (const auto &instr : code) {
+            if ((instr.op == Opcode::GlobalGet || instr.op == Opcode::GlobalSet)
+                    && index[instr.imm] == unused) {
+                index[instr.imm] = 0;
+                pending.push_back(instr.imm);
+            }
+        }
+    };
+    for (const auto &func : funcs) {
+        mark(func.body);
+    }
+    while (! pending.empty()) {
+        auto i = pending.back();
+        pending.pop_back();
+        mark(globals[i].init);
+    }
+
+    uint32_t num_kept = 0;
+    for (size_t i = 0; i < globals.size(); ++i) {
+        if (index[i] != unused) {
+            if (i != num_kept) {
+                globals[num_kept] = std::move(globals[i]);
+            }
+            index[i] = num_kept++;
+        }
+    }
+    if (num_kept == globals.size()) {
+        return;
+    }
+    globals.resize(num_kept);
+
+    auto renumber = [&](std::vector<Instr> &code) {
+        for (auto &instr : code) {
+            if (instr.op == Opcode::GlobalGet || instr.op == Opcode::GlobalSet) {
+                instr.imm = index[instr.imm];
+            }
+        }
+    };
+    for (auto &func : funcs) {
+        renumber(func.body);
+    }
+    for (auto &global : globals) {
+        renumber(global.init);
+    }
+}
+
+uint32_t Builder::declare_func(Symbol name, uint32_t num_params, bool has_result) {
+    assert(name);
+    assert(m_func_index.find(name) == m_func_index.end());
+
+    uint32_t index = m_module.funcs.size();
+    auto &func = m_module.funcs.emplace_back();
+    func.name = name;
+    func.num_params = num_params;
+    func.has_result = has_result;
+    m_func_index.emplace(name, index);
+    return index;
+}
+
+uint32_t Builder::find_func(Symbol name) const {
+    auto iter = m_func_index.find(name);
+    return iter == m_func_index.end() ? npos : iter->second;
+}
+
+uint32_t Builder::begin_global(Symbol name) {
+    assert(name);
+    assert(m_global_index.find(name) == m_global_index.end());
+    assert(m_cur_func == npos && m_cur_global == npos);
+
+    m_cur_global = m_module.globals.size();
+    m_module.globals.push_back({name, {}});
+    m_global_index.emplace(name, m_cur_global);
+    return m_cur_global;
+}
+
+void Builder::end_global() {
+    assert(m_cur_global != npos);
+    m_cur_global = npos;
+}
+
+uint32_t Builder::find_global(Symbol name) const {
+    auto iter = m_global_index.find(name);
+    return iter == m_global_index.end() ? npos : iter->second;
+}
+
+void Builder::begin_func(uint32_t func) {
+    assert(m_cur_func == npos);
+    assert(func < m_module.funcs.size());
+    m_cur_func = func;
+    m_locals.clear();
+    m_module.funcs[func].locals.clear();
+    m_module.funcs[func].body.clear();
+}
+
+uint32_t Builder::add_local(Symbol name) {
+    assert(m_cur_func != npos);
+    auto &locals = m_module.funcs[m_cur_func].locals;
+    uint32_t index = locals.size();
+    locals.push_back(name);
+    m_locals[name] = index;
+    return index;
+}
+
+uint32_t Builder::find_local(Symbol name) const {
+    auto iter = m_locals.find(name);
+    return iter == m_locals.end() ? npos : iter->second;
+}
+
+void Builder::end_func() {
+    assert(m_cur_func != npos);
+    assert(m_module.funcs[m_cur_func].locals.size() >= m_module.funcs[m_cur_func].num_params);
+    m_cur_func = npos;
+    m_locals.clear();
+}
+
+} // namespace ir
@@ -0,0 +1,193 @@
+#ifndef KIRAZ_IR_IR_H
+#define KIRAZ_IR_IR_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <kiraz/Interner.h>
+
+namespace ir {
+
+/* Value types. Every kiraz value is an i64, comparisons yield an i32 until it is widened back */
+enum class Type : uint8_t {
+    Void,
+    I32,
+    I64,
+};
+
+/* Stack machine operations, a typed subset of WebAssembly with structured control flow */
+enum class Opcode : uint8_t {
+    Unreachable,
+    Block,
+    Loop,
+    If,
+    Else,
+    End,
+    Br,
+    BrIf,
+    Return,
+    Call,
+    Drop,
+    LocalGet,
+    LocalSet,
+    GlobalGet,
+    GlobalSet,
+    Const,
+    Eqz,
+    Eq,
+    LtS,
+    GtS,
+    LeS,
+    GeS,
+    Add,
+    Sub,
+    Mul,
+    DivS,
+    And,
+    Or,
+    Wrap,
+    ExtendU,
+};
+
+/**
+ * @brief get_name: Returns the WAT mnemonic of the operation without its type prefix.
+ */
+const char *get_name(Opcode op);
+
+/**
+ * @brief Instr: One instruction. The type is the operand type of numeric operations and the result
+ *        type of block, loop and if. The immediate holds the constant, the local, global or
+ *        function index, or the branch depth.
+ */
+struct Instr {
+    Opcode op;
+    Type type = Type::Void;
+    int64_t imm = 0;
+};
+
+struct Function {
+    Symbol name;
+    uint32_t num_params = 0;
+    bool has_result = false;
+    bool exported = true;
+
+    /* Names of the parameters followed by the names of the locals, indexed like in the code */
+    std::vector<Symbol> locals;
+
+    /* Code without the closing end of the function body */
+    std::vector<Instr> body;
+};
+
+/* Mutable i64 global, the module level variables */
+struct Global {
+    Symbol name;
+
+    /* Code computing the initial value, a single const once the module is ready to be emitted */
+    std::vector<Instr> init;
+
+    bool has_const_init() const { return init.size() == 1 && init[0].op == Opcode::Const; }
+};
+
+struct Module {
+    /* Functions in index order, calls refer to them by position */
+    std::vector<Function> funcs;
+    std::vector<Global> globals;
+
+    /**
+     * @brief get_num_instrs: Returns the number of instructions in all function bodies.
+     */
+    size_t get_num_instrs() const;
+
+    /**
+     * @brief remove_unused_globals: Removes the globals no function refers to, directly or through
+     *        the initial value of another global.
+     */
+    void remove_unused_globals();
+};
+
+/**
+ * @brief Builder: Lowers the checked AST into a module. Functions are declared up front so calls
+ *        can refer to functions whose bodies come later, then their bodies are built one at a time
+ *        between begin_func and end_func.
+ */
+class Builder {
+public:
+    static constexpr uint32_t npos = UINT32_MAX;
+
+    explicit Builder(Module &module) : m_module(module) {}
+
+    /**
+     * @brief declare_func: Adds a function with the given number of i64 parameters to the module.
+     * @return Index of the function, to be passed to begin_func and to call instructions
+     */
+    uint32_t declare_func(Symbol name, uint32_t num_params, bool has_result);
+
+    /**
+     * @brief find_func: Returns the index of the function with the given name, npos if none.
+     */
+    uint32_t find_func(Symbol name) const;
+
+    /**
+     * @brief begin_global: Adds a module level variable, the code up to end_global computes its
+     *        initial value.
+     * @return Index of the global
+     */
+    uint32_t begin_global(Symbol name);
+    void end_global();
+
+    /**
+     * @brief find_global: Returns the index of the global with the given name, npos if none.
+     */
+    uint32_t find_global(Symbol name) const;
+
+    bool has_result(uint32_t func) const { return m_module.funcs[func].has_result; }
+    uint32_t get_num_params(uint32_t func) const { return m_module.funcs[func].num_params; }
+
+    void begin_func(uint32_t func);
+    void end_func();
+    auto get_cur_func() const { return m_cur_func; }
+
+    /**
+     * @brief add_local: Allocates a local of the current function. Parameters have to be added
+     *        first and in order, their indices are the ones the caller passes them in.
+     */
+    uint32_t add_local(Symbol name);
+
+    /**
+     * @brief find_local: Returns the index of the local with the given name, npos if none.
+     */
+    uint32_t find_local(Symbol name) const;
+
+    void op(Opcode op, Type type = Type::Void) { code().push_back({op, type, 0}); }
+    void op(Opcode op, uint32_t immediate) { code().push_back({op, Type::Void, immediate}); }
+    void i64_const(int64_t value) { code().push_back({Opcode::Const, Type::I64, value}); }
+
+    /* Comparisons yield an i32, widen it back to the i64 every value is */
+    void compare(Opcode op) {
+        this->op(op, Type::I64);
+        this->op(Opcode::ExtendU, Type::I32);
+    }
+
+    /* Structured instructions without a result value */
+    void block(Opcode op) { this->op(op, Type::Void); }
+
+private:
+    std::vector<Instr> &code() {
+        return m_cur_global == npos ? m_module.funcs[m_cur_func].body
+                                    : m_module.globals[m_cur_global].init;
+    }
+
+    Module &m_module;
+    std::unordered_map<Symbol, uint32_t> m_func_index;
+    std::unordered_map<Symbol, uint32_t> m_global_index;
+
+    /* State of the function or global initializer that is being built */
+    uint32_t m_cur_func = npos;
+    uint32_t m_cur_global = npos;
+    std::unordered_map<Symbol, uint32_t> m_locals;
+};
+
+} // namespace ir
+
+#endif // KIRAZ_IR_IR_H
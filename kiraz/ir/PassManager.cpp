@@ -0,0 +1,23 @@
+
+#include "PassManager.h"
+
+#include <cassert>
+
+namespace ir {
+
+void PassManager::add(std::unique_ptr<Pass> pass) {
+    assert(pass);
+    m_timings.push_back({pass->get_name()});
+    m_passes.push_back(std::move(pass));
+}
+
+void PassManager::run(Module &module) {
+    for (size_t i = 0; i < m_passes.size(); ++i) {
+        auto start = Clock::now();
+        m_passes[i]->run(module);
+        m_timings[i].elapsed += Clock::now() - start;
+        ++m_timings[i].num_runs;
+    }
+}
+
+} // namespace ir
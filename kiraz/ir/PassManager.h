@@ -0,0 +1,64 @@
+#ifndef KIRAZ_IR_PASSMANAGER_H
+#define KIRAZ_IR_PASSMANAGER_H
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <kiraz/ir/IR.h>
+
+namespace ir {
+
+/**
+ * @brief Pass: One transformation of a module. Passes run in the order they were added to the
+ *        pass manager and leave the module valid for the passes after them.
+ */
+class Pass {
+public:
+    virtual ~Pass() = default;
+
+    virtual const char *get_name() const = 0;
+    virtual void run(Module &module) = 0;
+};
+
+/**
+ * @brief PassManager: Runs an ordered list of passes over a module and measures the time spent in
+ *        each of them. Timings accumulate over every module the manager runs on.
+ */
+class PassManager {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Timing {
+        const char *name;
+        Clock::duration elapsed{};
+        size_t num_runs = 0;
+    };
+
+    template <typename T, typename... Args>
+    T &add(Args &&...args) {
+        auto pass = std::make_unique<T>(std::forward<Args>(args)...);
+        auto &retval = *pass;
+        add(std::move(pass));
+        return retval;
+    }
+
+    void add(std::unique_ptr<Pass> pass);
+
+    void run(Module &module);
+
+    auto get_num_passes() const { return m_passes.size(); }
+
+    /**
+     * @brief get_timings: Returns one entry per pass, in the order the passes run.
+     */
+    const auto &get_timings() const { return m_timings; }
+
+private:
+    std::vector<std::unique_ptr<Pass>> m_passes;
+    std::vector<Timing> m_timings;
+};
+
+} // namespace ir
+
+#endif // KIRAZ_IR_PASSMANAGER_H
@@ -0,0 +1,21 @@
+// Validates a module kirazc -w wrote and calls one of its exports, printing
+// "<export>(<args>) = <result>". Usage:
+//   node run_wasm.js <module.wasm> <export> [integer arguments...]
+const fs = require('fs');
+
+const [file, name, ...args] = process.argv.slice(2);
+const bytes = fs.readFileSync(file);
+if (! WebAssembly.validate(bytes)) {
+    console.error(`${file}: invalid module`);
+    process.exit(1);
+}
+
+const instance = new WebAssembly.Instance(new WebAssembly.Module(bytes));
+const func = instance.exports[name];
+if (typeof func !== 'function') {
+    console.error(`${file}: no exported function '${name}'`);
+    process.exit(1);
+}
+
+// Integer64 is i64, which JavaScript passes as BigInt
+console.log(`${name}(${args.join(', ')}) = ${func(...args.map(BigInt))}`);
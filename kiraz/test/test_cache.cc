@@ -0,0 +1,28 @@
+#include <filesystem>
+
+#include <gtest/gtest.h>
+
+#include <kiraz/CompileCache.h>
+#include <kiraz/Node.h>
+
+TEST(CompileCache, evicts_least_recently_used) {
+    const std::string cache_dir = "./kiraz_test_cache_evict";
+    std::filesystem::remove_all(cache_dir);
+    CompileCache cache(cache_dir, 1000);
+
+    /* perform */
+    std::string output;
+    for (size_t i = 0; i < 10; ++i) {
+        cache.store("wat", FF("source {}", i), {}, std::string(200, 'x'));
+        ASSERT_TRUE(cache.lookup("wat", FF("source {}", i), output));
+    }
+
+    /* verify */
+    ASSERT_EQ(output, std::string(200, 'x'));
+    ASSERT_GT(cache.get_counters().evictions, 0);
+    ASSERT_TRUE(cache.lookup("wat", "source 9", output));
+    ASSERT_FALSE(cache.lookup("wat", "source 0", output));
+    ASSERT_FALSE(cache.lookup("wasm", "source 9", output));
+
+    std::filesystem::remove_all(cache_dir);
+}
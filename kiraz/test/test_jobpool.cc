@@ -0,0 +1,81 @@
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <kiraz/Compiler.h>
+#include <kiraz/JobPool.h>
+
+TEST(JobPool, runs_every_job_once) {
+    constexpr size_t num_jobs = 1000;
+    std::vector<std::atomic<int>> runs(num_jobs);
+    JobPool pool(4);
+
+    /* perform */
+    for (size_t round = 0; round < 2; ++round) {
+        for (size_t i = 0; i < num_jobs; ++i) {
+            pool.submit([&runs, i] { ++runs[i]; });
+        }
+        pool.wait();
+    }
+
+    /* jobs may submit more jobs, wait() covers those too */
+    std::atomic<int> nested = 0;
+    pool.submit([&pool, &nested] {
+        for (size_t i = 0; i < 10; ++i) {
+            pool.submit([&nested] { ++nested; });
+        }
+    });
+    pool.wait();
+
+    /* verify */
+    for (size_t i = 0; i < num_jobs; ++i) {
+        ASSERT_EQ(runs[i], 2) << i;
+    }
+    ASSERT_EQ(nested, 10);
+}
+
+TEST(JobPool, runs_independent_compilers) {
+    constexpr size_t num_jobs = 40;
+    struct Result {
+        int status = -1;
+        std::string output;
+        std::string error;
+    };
+    std::vector<Result> results(num_jobs);
+
+    /* perform, every fifth source refers to an undefined name, errors must not cross jobs */
+    {
+        JobPool pool(4);
+        for (size_t i = 0; i < num_jobs; ++i) {
+            pool.submit([&results, i] {
+                std::string code;
+                for (size_t j = 0; j < (num_jobs - i) * 5; ++j) {
+                    code += FF("func g{}() : Integer64 {{ return {}; }};", j, j);
+                }
+                code += i % 5 ? FF("func f{}() : Integer64 {{ return {}; }};", i, i)
+                              : FF("func f{}() : Integer64 {{ return x{}; }};", i, i);
+
+                Compiler compiler;
+                results[i].status = compiler.compile_string(code);
+                results[i].output = compiler.get_wasm_ctx().body().str();
+                results[i].error = compiler.get_error();
+            });
+        }
+        pool.wait();
+    }
+
+    /* verify */
+    for (size_t i = 0; i < num_jobs; ++i) {
+        if (i % 5) {
+            ASSERT_EQ(results[i].status, 0) << i << ": " << results[i].error;
+            ASSERT_NE(results[i].output.find(FF("(func $f{} ", i)), std::string::npos) << i;
+        }
+        else {
+            ASSERT_NE(results[i].status, 0) << i;
+            ASSERT_NE(results[i].error.find(FF("'x{}'", i)), std::string::npos)
+                    << i << ": " << results[i].error;
+        }
+    }
+}
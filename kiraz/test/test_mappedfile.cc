@@ -0,0 +1,66 @@
+#include <cerrno>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <kiraz/MappedFile.h>
+
+TEST(MappedFile, maps_empty_file) {
+    const std::string file_name = "./kiraz_test_empty.ki";
+    std::ofstream(file_name).close();
+
+    /* perform */
+    MappedFile file;
+    ASSERT_TRUE(file.open(file_name));
+
+    /* verify */
+    ASSERT_EQ(file.size(), 0);
+    ASSERT_EQ(file.get_buffer_size(), 2);
+    ASSERT_EQ(file.data()[0], '\0');
+    ASSERT_EQ(file.data()[1], '\0');
+
+    std::filesystem::remove(file_name);
+}
+
+TEST(MappedFile, reports_missing_file) {
+    const std::string file_name = "./kiraz_test_missing.ki";
+    std::filesystem::remove(file_name);
+
+    /* perform */
+    MappedFile file;
+    errno = 0;
+    auto ok = file.open(file_name);
+
+    /* verify */
+    ASSERT_FALSE(ok);
+    ASSERT_EQ(errno, ENOENT);
+    ASSERT_EQ(file.size(), 0);
+}
+
+TEST(MappedFile, terminates_page_sized_file) {
+    const std::string file_name = "./kiraz_test_page.ki";
+    const auto page_size = size_t(sysconf(_SC_PAGESIZE));
+    const std::string contents(2 * page_size, 'x');
+    std::ofstream(file_name, std::ios::binary) << contents;
+
+    /* perform */
+    MappedFile file;
+    ASSERT_TRUE(file.open(file_name));
+
+    /* verify */
+    ASSERT_EQ(file.size(), contents.size());
+    ASSERT_EQ(std::string_view(file.data(), file.size()), contents);
+    ASSERT_EQ(file.data()[contents.size()], '\0');
+    ASSERT_EQ(file.data()[contents.size() + 1], '\0');
+
+    /* the scanner writes into the buffer, the file stays as it was */
+    file.data()[0] = 'y';
+    file.data()[contents.size()] = 'y';
+    std::ifstream in(file_name, std::ios::binary);
+    ASSERT_EQ(std::string(std::istreambuf_iterator<char>(in), {}), contents);
+
+    std::filesystem::remove(file_name);
+}
@@ -0,0 +1,66 @@
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <kiraz/Node.h>
+#include <kiraz/OutputBuffer.h>
+
+TEST(OutputBuffer, appends_across_chunks) {
+    OutputBuffer buffer;
+    std::string expected;
+
+    /* perform */
+    for (size_t i = 0; i < 500; ++i) {
+        auto text = std::string(i % 97 + 1, char('a' + i % 26));
+        buffer << text << -int64_t(i) << ' ';
+        expected += FF("{}{} ", text, -int64_t(i));
+    }
+
+    /* verify */
+    size_t num_chunks = 0;
+    std::string chunks;
+    buffer.for_each_chunk([&](std::string_view text) {
+        ++num_chunks;
+        chunks += text;
+    });
+    ASSERT_GT(num_chunks, 1);
+    ASSERT_EQ(chunks, expected);
+    ASSERT_EQ(buffer.size(), expected.size());
+    ASSERT_EQ(buffer.str(), expected);
+
+    /* a piece larger than any chunk goes in whole */
+    auto large = std::string(256 * 1024, 'z');
+    buffer << large;
+    ASSERT_EQ(buffer.str(), expected + large);
+}
+
+TEST(OutputBuffer, splices_chunks) {
+    OutputBuffer inner, outer;
+    std::string expected_inner, expected_outer;
+    for (size_t i = 0; i < 100; ++i) {
+        inner << "inner " << i << '\n';
+        expected_inner += FF("inner {}\n", i);
+    }
+    outer << "head\n";
+
+    /* perform */
+    outer.splice(inner);
+    outer << "tail\n";
+    outer.splice(outer);
+    outer.splice(inner);
+
+    /* verify */
+    ASSERT_TRUE(inner.empty());
+    ASSERT_EQ(inner.str(), "");
+    expected_outer = "head\n" + expected_inner + "tail\n";
+    ASSERT_EQ(outer.size(), expected_outer.size());
+    ASSERT_EQ(outer.str(), expected_outer);
+
+    /* the emptied buffer is usable again, and splicing into an empty one takes everything */
+    inner << "again";
+    OutputBuffer empty;
+    empty.splice(outer);
+    ASSERT_EQ(inner.str(), "again");
+    ASSERT_TRUE(outer.empty());
+    ASSERT_EQ(empty.str(), expected_outer);
+}
@@ -4,15 +4,19 @@
 #include <lexer.hpp>
 #include <main.h>
 
+#include <kiraz/Compiler.h>
 #include <kiraz/Node.h>
+#include <kiraz/Prelude.h>
+#include <kiraz/ast/Statement.h>
 
-extern std::shared_ptr<Token> curtoken;
+#include <atomic>
+#include <thread>
 
 struct ParserFixture : public testing::Test {
+    Compiler compiler;
     YY_BUFFER_STATE buffer = nullptr;
 
     void SetUp() override {
-        Node::reset_root();
         // yydebug = 1; // uncomment to your heart's content
     }
 
@@ -20,20 +24,18 @@ struct ParserFixture : public testing::Test {
         // Tear down code after each test, even if assertions fail.
         // This will be executed even in the face of assertion failures.
         if (buffer) {
-            yy_delete_buffer(buffer);
+            yy_delete_buffer(buffer, compiler.get_scanner());
             buffer = nullptr;
         }
 
         yydebug = 0;
-        Token::colno = 0;
-        curtoken.reset();
     }
 
     void verify_root(const std::string &code, const std::string &ast) {
-        buffer = yy_scan_string(code.data());
+        buffer = yy_scan_string(code.data(), compiler.get_scanner());
 
         /* perform */
-        yyparse();
+        yyparse(compiler.get_scanner());
 
         /* verify */
         ASSERT_TRUE(Node::current_root());
@@ -42,10 +44,10 @@ struct ParserFixture : public testing::Test {
     }
 
     void verify_single(const std::string &code, const std::string &ast) {
-        buffer = yy_scan_string(code.data());
+        buffer = yy_scan_string(code.data(), compiler.get_scanner());
 
         /* perform */
-        yyparse();
+        yyparse(compiler.get_scanner());
 
         /* verify */
         ASSERT_TRUE(Node::current_root());
@@ -58,10 +60,10 @@ struct ParserFixture : public testing::Test {
     }
 
     void verify_no_root(const std::string &code) {
-        buffer = yy_scan_string(code.data());
+        buffer = yy_scan_string(code.data(), compiler.get_scanner());
 
         /* perform */
-        yyparse();
+        yyparse(compiler.get_scanner());
 
         /* verify */
         ASSERT_FALSE(Node::current_root());
@@ -485,3 +487,122 @@ TEST_F(ParserFixture, return_bad_operand) {
 TEST_F(ParserFixture, bonus) {
     verify_no_root("1---2;");
 }
+
+TEST(ParserThreads, concurrent_compilers) {
+    constexpr int num_threads = 8;
+    constexpr int num_iterations = 64;
+
+    std::atomic<int> failures = 0;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([t, &failures] {
+            for (int i = 0; i < num_iterations; ++i) {
+                Compiler compiler;
+
+                /* perform */
+                auto ret = compiler.compile_string(FF(
+                        "func f{}(a: Integer64) : Integer64 {{ let x = {} + {}; return x; }};",
+                        t, i, t));
+
+                /* verify */
+                auto ast = FF("Module([Func(n=Id(f{}), a=FuncArgs([FArg(n=Id(a), t=Id(Integer64))]), "
+                              "r=Id(Integer64), s=[Let(n=Id(x), i=Add(l=Int({}), r=Int({}))), "
+                              "Return(Id(x))])])",
+                        t, i, t);
+                if (ret != 0 || ! Node::get_root_before()
+                        || Node::get_root_before()->as_string() != ast) {
+                    ++failures;
+                }
+            }
+        });
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    ASSERT_EQ(failures, 0);
+}
+
+TEST(ParserLimits, million_top_level_statements) {
+    constexpr size_t num_stmts = 1000000;
+
+    std::string code;
+    code.reserve(num_stmts * 16);
+    for (size_t i = 0; i < num_stmts; ++i) {
+        code += FF("let v{} = {};\n", i, i);
+    }
+
+    Compiler compiler;
+
+    /* perform */
+    auto ret = compiler.compile_string(code);
+
+    /* verify */
+    ASSERT_EQ(ret, 0) << compiler.get_error();
+    auto module = std::dynamic_pointer_cast<ast::Module>(Node::get_root_before());
+    ASSERT_TRUE(module);
+    ASSERT_EQ(ast::StatementList::statements_of(module->get_statements()).size(), num_stmts);
+}
+
+TEST(ParserLimits, long_parameter_list) {
+    constexpr size_t num_params = 100000;
+
+    std::string code = "func f(";
+    for (size_t i = 0; i < num_params; ++i) {
+        code += FF("{}p{}: Integer64", i ? ", " : "", i);
+    }
+    code += ") : Integer64 { return p0; };";
+
+    Compiler compiler;
+
+    /* perform */
+    auto ret = compiler.compile_string(code);
+
+    /* verify */
+    ASSERT_EQ(ret, 0) << compiler.get_error();
+    auto module = std::dynamic_pointer_cast<ast::Module>(Node::get_root_before());
+    ASSERT_TRUE(module);
+    auto func = std::dynamic_pointer_cast<ast::FunctionStatement>(
+            ast::StatementList::statements_of(module->get_statements()).front());
+    ASSERT_TRUE(func);
+    ASSERT_EQ(func->get_parameter_list().size(), num_params);
+}
+
+TEST(Prelude, round_trip) {
+    Compiler compiler;
+    auto module = compiler.compile_module(
+            "func print(s: String) : Void {};"
+            "class Memory : Base { let size: Integer64 = 4; let ready = true;"
+            "    func read(offset: Integer64, length: Integer64) : String {}; };");
+
+    /* perform */
+    Prelude::Bytes blob;
+    auto ret = Prelude::encode(module, blob);
+    auto decoded = Prelude::decode({reinterpret_cast<const char *>(blob.data()), blob.size()});
+
+    /* verify */
+    ASSERT_FALSE(ret);
+    ASSERT_TRUE(decoded);
+    ASSERT_EQ(decoded->as_string(), module->as_string());
+}
+
+TEST(Prelude, rejects_code) {
+    Compiler compiler;
+    auto module = compiler.compile_module("func f() : Integer64 { return 1 + 2; };");
+
+    /* perform */
+    Prelude::Bytes blob;
+    auto ret = Prelude::encode(module, blob);
+
+    /* verify */
+    ASSERT_TRUE(ret);
+    ASSERT_EQ(ret->as_string(), "Return(Add(l=Int(1), r=Int(2)))");
+}
+
+TEST(Prelude, io_is_embedded) {
+    Compiler compiler;
+    auto io = std::dynamic_pointer_cast<ast::Module>(compiler.get_module_io());
+    ASSERT_TRUE(io);
+    ASSERT_FALSE(ast::StatementList::statements_of(io->get_statements()).empty());
+}
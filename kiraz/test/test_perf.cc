@@ -0,0 +1,291 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <new>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include <gtest/gtest.h>
+
+#include <fmt/format.h>
+
+#include <kiraz/CompileStats.h>
+#include <kiraz/Compiler.h>
+
+/*
+ * Compile time regression gate. Each test compiles one of the corpora kiraz_gen writes at build
+ * time and compares what it cost against perf_baseline.txt, which also holds the tolerance. The
+ * tests are only registered with -DKIRAZ_PERF_TESTS=ON, run them with `ctest -L perf`, and
+ * refresh the baseline on purpose with `KIRAZ_PERF_UPDATE=1 ctest -L perf`.
+ *
+ * Every figure fails a test once it exceeds its baseline by more than the tolerance of its kind.
+ * Times, arena bytes, resident set growth and heap allocations are taken per phase, so the
+ * failure names the phase that regressed. Times are in units of a calibration workload, which
+ * takes out most of the speed of the machine. Resident set growth is what the phase itself added
+ * to the resident set, it does not depend on the tests that ran before.
+ */
+
+namespace {
+
+/* Heap allocations per phase of the compiler on the allocating thread */
+std::array<std::atomic<uint64_t>, size_t(CompileStats::Phase::Count)> s_num_allocs;
+
+} // namespace
+
+void *operator new(size_t size) {
+    if (auto compiler = Compiler::current()) {
+        auto phase = compiler->get_stats().get_current();
+        s_num_allocs[size_t(phase)].fetch_add(1, std::memory_order_relaxed);
+    }
+    if (auto retval = std::malloc(size ? size : 1)) {
+        return retval;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+
+namespace kiraz {
+namespace {
+
+/* Every corpus is compiled this many times, the cheapest run of each phase counts */
+constexpr size_t NUM_RUNS = 5;
+
+/* Ordered metric name and value pairs, eg. "time.parse" or "lookups" */
+using Metrics = std::vector<std::pair<std::string, double>>;
+
+/**
+ * @brief calibrate: Returns the milliseconds a fixed workload takes on this machine, the unit of
+ *        the times in the baseline.
+ */
+double calibrate() {
+    using Clock = std::chrono::steady_clock;
+
+    double retval = 0;
+    for (size_t run = 0; run < NUM_RUNS; ++run) {
+        std::mt19937_64 rng(1);
+        std::vector<uint64_t> values(1 << 20);
+        for (auto &value : values) {
+            value = rng();
+        }
+
+        auto begin = Clock::now();
+        std::sort(values.begin(), values.end());
+        std::map<uint64_t, uint64_t> tree;
+        for (size_t i = 0; i < values.size(); i += 8) {
+            tree.emplace(values[i] ^ (values[i] >> 7), i);
+        }
+        auto elapsed = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+        if (run == 0 || elapsed < retval) {
+            retval = elapsed;
+        }
+    }
+    return retval;
+}
+
+struct Run {
+    CompileStats stats;
+    std::array<uint64_t, size_t(CompileStats::Phase::Count)> num_allocs{};
+};
+
+Metrics measure(const std::string &corpus) {
+    using Phase = CompileStats::Phase;
+
+    auto file_name = FF("{}/{}.ki", KIRAZ_PERF_CORPUS_DIR, corpus);
+    std::vector<Run> runs(NUM_RUNS);
+    for (auto &run : runs) {
+        std::array<uint64_t, size_t(Phase::Count)> before;
+        for (size_t i = 0; i < before.size(); ++i) {
+            before[i] = s_num_allocs[i].load();
+        }
+#ifdef __GLIBC__
+        // hands the memory of the previous run back, so this one grows the resident set again
+        malloc_trim(0);
+#endif
+        {
+            Compiler compiler;
+            compiler.get_stats().set_detailed(true);
+            EXPECT_EQ(compiler.compile_file(file_name), 0) << compiler.get_error();
+            run.stats = compiler.get_stats();
+        }
+        for (size_t i = 0; i < before.size(); ++i) {
+            run.num_allocs[i] = s_num_allocs[i].load() - before[i];
+        }
+    }
+
+    auto unit = calibrate();
+
+    Metrics retval;
+    // the cheapest run of a phase is the one least disturbed by the rest of the machine
+    auto add = [&](const char *kind, auto &&get_value) {
+        for (size_t i = size_t(Phase::None) + 1; i < size_t(Phase::Count); ++i) {
+            double value = get_value(runs.front(), Phase(i));
+            for (const auto &run : runs) {
+                value = std::min<double>(value, get_value(run, Phase(i)));
+            }
+            retval.emplace_back(FF("{}.{}", kind, CompileStats::get_name(Phase(i))), value);
+        }
+    };
+
+    add("time", [&](const Run &run, Phase phase) {
+        return std::chrono::duration<double, std::milli>(run.stats.get(phase).elapsed).count()
+                / unit;
+    });
+    add("arena", [](const Run &run, Phase phase) { return run.stats.get(phase).arena_bytes; });
+    add("rss", [](const Run &run, Phase phase) { return run.stats.get(phase).rss_growth; });
+    add("heap_allocs", [](const Run &run, Phase phase) { return run.num_allocs[size_t(phase)]; });
+
+    const auto &last = runs.back().stats;
+    retval.emplace_back("tokens", last.num_tokens);
+    retval.emplace_back("nodes", last.num_nodes);
+    retval.emplace_back("scopes", last.num_scopes);
+    retval.emplace_back("lookups", last.num_lookups);
+    retval.emplace_back("bytes_emitted", last.num_bytes_emitted);
+    return retval;
+}
+
+std::string get_kind(const std::string &metric) {
+    auto dot = metric.find('.');
+    if (dot != std::string::npos) {
+        return metric.substr(0, dot);
+    }
+    return "counter";
+}
+
+/*
+ * The baseline holds one "<corpus> <metric> <value>" line per figure, one
+ * "tolerance <kind> <fraction>" line per kind of metric, see get_kind(), and optionally one
+ * "slack <kind> <value>" line per kind. A figure may exceed its baseline by the fraction plus
+ * the slack, which keeps phases that take next to nothing from failing on noise.
+ */
+struct Baseline {
+    std::vector<std::string> lines;
+    std::map<std::string, double> tolerances;
+    std::map<std::string, double> slacks;
+    std::map<std::string, std::map<std::string, double>> values;
+
+    bool load(const std::string &file_name) {
+        std::ifstream file(file_name);
+        if (! file.is_open()) {
+            return false;
+        }
+        for (std::string line; std::getline(file, line);) {
+            lines.push_back(line);
+
+            std::istringstream fields(line);
+            std::string first, second;
+            double value;
+            if (line.starts_with("#") || ! (fields >> first >> second >> value)) {
+                continue;
+            }
+            if (first == "tolerance") {
+                tolerances[second] = value;
+            }
+            else if (first == "slack") {
+                slacks[second] = value;
+            }
+            else {
+                values[first][second] = value;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief update: Replaces the figures of the given corpus, keeping everything else.
+     */
+    bool update(const std::string &file_name, const std::string &corpus, const Metrics &metrics) {
+        std::ofstream file(file_name, std::ios::trunc);
+        for (const auto &line : lines) {
+            if (! line.starts_with(corpus + " ")) {
+                file << line << '\n';
+            }
+        }
+        for (const auto &[metric, value] : metrics) {
+            // four digits are plenty for times, the other figures are kept whole
+            if (get_kind(metric) == "time") {
+                file << FF("{} {} {:.4g}\n", corpus, metric, value);
+            }
+            else {
+                file << FF("{} {} {:.0f}\n", corpus, metric, value);
+            }
+        }
+        return bool(file);
+    }
+};
+
+std::string describe(const std::string &metric) {
+    auto dot = metric.find('.');
+    if (dot == std::string::npos) {
+        return FF("'{}'", metric);
+    }
+    return FF("phase '{}' {}", metric.substr(dot + 1), metric.substr(0, dot));
+}
+
+void run(const std::string &corpus) {
+    auto metrics = measure(corpus);
+
+    Baseline baseline;
+    bool loaded = baseline.load(KIRAZ_PERF_BASELINE);
+    if (std::getenv("KIRAZ_PERF_UPDATE")) {
+        ASSERT_TRUE(baseline.update(KIRAZ_PERF_BASELINE, corpus, metrics))
+                << "Unable to write " << KIRAZ_PERF_BASELINE;
+        return;
+    }
+    ASSERT_TRUE(loaded) << "Unable to read " << KIRAZ_PERF_BASELINE;
+
+    auto iter = baseline.values.find(corpus);
+    ASSERT_TRUE(iter != baseline.values.end())
+            << "No baseline for " << corpus << ", record one with KIRAZ_PERF_UPDATE=1";
+    const auto &expected = iter->second;
+
+    std::string report = FF("{:<24}{:>14}{:>14}{:>9}\n", corpus, "baseline", "current", "change");
+    for (const auto &[metric, value] : metrics) {
+        auto base = expected.find(metric);
+        if (base == expected.end()) {
+            ADD_FAILURE() << "No baseline for " << corpus << " " << metric;
+            continue;
+        }
+
+        auto kind = get_kind(metric);
+        auto change = base->second ? value / base->second - 1 : (value ? 1.0 : 0.0);
+        report += FF("{:<24}{:>14.4g}{:>14.4g}{:>+8.1f}%\n", metric, base->second, value,
+                change * 100);
+
+        auto tolerance = baseline.tolerances.find(kind);
+        if (tolerance == baseline.tolerances.end()) {
+            ADD_FAILURE() << "No tolerance for " << kind << " in " << KIRAZ_PERF_BASELINE;
+            continue;
+        }
+        auto slack = baseline.slacks[kind];
+        if (value <= base->second * (1 + tolerance->second) + slack) {
+            continue;
+        }
+        ADD_FAILURE() << FF("{}: {} regressed, {:.6g} against {:.6g} in the baseline ({:+.1f}%, "
+                            "tolerance {:.0f}% + {:.6g})",
+                corpus, describe(metric), value, base->second, change * 100,
+                tolerance->second * 100, slack);
+    }
+
+    std::cout << report;
+}
+
+} // namespace
+
+TEST(Perf, funcs) { run("funcs"); }
+
+TEST(Perf, classes) { run("classes"); }
+
+TEST(Perf, nested) { run("nested"); }
+
+} // namespace kiraz
@@ -1,4 +1,6 @@
 
+#include <filesystem>
+#include <fstream>
 #include <regex>
 
 #include <gtest/gtest.h>
@@ -6,8 +8,11 @@
 #include <lexer.hpp>
 #include <main.h>
 
+#include <kiraz/CompileCache.h>
 #include <kiraz/Compiler.h>
+#include <kiraz/ModuleInterface.h>
 #include <kiraz/Node.h>
+#include <kiraz/ast/Statement.h>
 
 extern int yydebug;
 
@@ -235,6 +240,11 @@ TEST_F(CompilerFixture, func_has_not) {
     verify_ok("func m() : Void { not(true); };");
 }
 
+TEST_F(CompilerFixture, call_plain_function) {
+    verify_ok("func g(a: Integer64) : Integer64 { return a; };"
+              "func f() : Integer64 { return g(1); };");
+}
+
 TEST_F(CompilerFixture, func_has_Boolean) {
     verify_ok("func m() : Boolean { return true; };");
 }
@@ -454,4 +464,327 @@ TEST_F(CompilerFixture, io_print_call_overload_bool) {
 TEST_F(CompilerFixture, io_print_call_overload_custom) {
     verify_error("import io; class C {}; func f() : Void { let c: C; io.print(c); };");
 }
+
+struct StubNode : public Node {
+    std::string as_string() const override { return "Stub"; }
+};
+
+TEST(SymbolTable, scope_sees_parent_as_of_entry) {
+    Compiler compiler;
+    SymbolTable st(ScopeType::Module);
+    auto func = std::make_shared<StubNode>();
+    auto before = std::make_shared<StubNode>();
+    auto after = std::make_shared<StubNode>();
+
+    st.add_symbol("before", before);
+    func->set_cur_symtab(st.get_cur_symtab());
+    Scope::Ptr inner;
+    {
+        auto scope = st.enter_scope(ScopeType::Func, func);
+        st.add_symbol("local", func);
+        ASSERT_EQ(st.lookup("before"), before);
+        ASSERT_EQ(st.lookup_in_current_scope("local"), func);
+        inner = st.get_cur_symtab();
+    }
+
+    ASSERT_FALSE(st.lookup("local"));
+    st.add_symbol("after", after);
+    st.add_symbol("before", after);
+
+    ASSERT_EQ(inner->find(SymbolTable::get_names().find("before")), before);
+    ASSERT_FALSE(inner->find(SymbolTable::get_names().find("after")));
+    ASSERT_EQ(st.lookup("before"), after);
+}
+
+TEST(SymbolTable, moved_scope_ref_exits_once) {
+    Compiler compiler;
+    SymbolTable st(ScopeType::Module);
+    auto func = std::make_shared<StubNode>();
+    auto module = st.get_cur_symtab();
+    func->set_cur_symtab(module);
+
+    /* perform */
+    {
+        auto enter = [&] {
+            auto retval = st.enter_scope(ScopeType::Func, func);
+            st.add_symbol("local", func);
+            return retval;
+        };
+        auto scope = enter();
+        auto moved = std::move(scope);
+        ASSERT_TRUE(st.lookup("local"));
+    }
+
+    /* verify */
+    ASSERT_EQ(st.get_cur_symtab(), module);
+    ASSERT_FALSE(st.lookup("local"));
+}
+
+TEST(SymbolTable, enter_scope_shares_parents) {
+    constexpr size_t num_funcs = 10000;
+    Compiler compiler;
+    const auto &stats = compiler.get_stats();
+
+    /* Mimics the module pass: every function enters its own scope below a module scope that
+     * already holds all functions */
+    SymbolTable st(ScopeType::Module);
+    std::vector<Node::Ptr> funcs;
+    for (size_t i = 0; i < num_funcs; ++i) {
+        funcs.emplace_back(std::make_shared<StubNode>());
+        st.add_symbol(FF("f{}", i), funcs.back());
+    }
+    auto num_scopes = stats.num_scopes;
+    auto num_lookups = stats.num_lookups;
+
+    /* perform */
+    size_t num_locals = 0;
+    for (const auto &func : funcs) {
+        func->set_cur_symtab(st.get_cur_symtab());
+        auto scope = st.enter_scope(ScopeType::Func, func);
+        st.add_symbol("x", func);
+        st.get_cur_symtab()->for_each_local([&](const auto &, const auto &) { ++num_locals; });
+        EXPECT_TRUE(st.lookup("f0"));
+    }
+
+    /* verify: the module scope is reached through the parent, not copied into every function */
+    ASSERT_EQ(num_locals, num_funcs);
+    ASSERT_EQ(stats.num_scopes - num_scopes, num_funcs);
+    ASSERT_EQ(stats.num_lookups - num_lookups, num_funcs);
+}
+
+/* Imports are resolved relative to the working directory */
+struct ImportFixture : public CompilerFixture {
+    static constexpr const char *source_name = "./kiraz_test_import.ki";
+
+    void SetUp() override {
+        std::ofstream(source_name) << "class Point { let x: Integer64; let y = 0; };"
+                                      "func norm(p: Integer64) : Integer64 { return p * p; };";
+    }
+
+    void TearDown() override {
+        std::filesystem::remove(source_name);
+        std::filesystem::remove(ModuleInterface::get_file_name(source_name));
+    }
+};
+
+TEST_F(ImportFixture, writes_interface) {
+    verify_ok("import kiraz_test_import; func f() : Void { let p: Point; p.x; };");
+    ASSERT_TRUE(std::filesystem::exists(ModuleInterface::get_file_name(source_name)));
+
+    /* the second import maps the interface */
+    verify_ok("import kiraz_test_import; func f() : Void { let p: Point; p.y; };");
+    verify_error("import kiraz_test_import; func f() : Void { let p: Point; p.z; };",
+            "Identifier 'p.z' is not found");
+}
+
+TEST_F(ImportFixture, import_redefinition) {
+    verify_error("import kiraz_test_import; func norm() : Void {};",
+            "Identifier 'norm' is already in symtab");
+    verify_error("func norm() : Void {}; import kiraz_test_import;",
+            "Identifier 'norm' is already in symtab");
+}
+
+TEST_F(ImportFixture, malformed_module) {
+    std::ofstream(source_name, std::ios::trunc) << "func norm(p: Integer64) : { return p; };";
+    verify_error("import kiraz_test_import; func f() : Integer64 { return 1; };",
+            "Failed to parse module 'kiraz_test_import': Parser Error at 1:27: syntax error at "
+            "token: OP_LBRACE");
+    ASSERT_FALSE(std::filesystem::exists(ModuleInterface::get_file_name(source_name)));
+}
+
+TEST_F(ImportFixture, rebuilds_corrupt_interface) {
+    const std::string code = "import kiraz_test_import;"
+                             "func f() : Integer64 { let p: Point; p.y; return norm(2); };";
+    verify_ok(code);
+
+    /* perform */
+    auto interface_name = ModuleInterface::get_file_name(source_name);
+    auto size = std::filesystem::file_size(interface_name);
+    std::string data(size, 0);
+    std::ifstream(interface_name, std::ios::binary).read(data.data(), size);
+    std::vector<std::string> corruptions = {
+            data.substr(0, size - 5), // truncated declaration
+            data.substr(0, 28), // entries beyond the end
+    };
+    auto garbled = data;
+    auto decl = garbled.begin() + garbled.find("Point", 28) + 5;
+    std::fill(decl, decl + 4, char(0xee)); // an unknown tag where the class begins
+    corruptions.push_back(garbled);
+
+    /* verify */
+    for (const auto &corruption : corruptions) {
+        {
+            std::ofstream file(interface_name, std::ios::binary | std::ios::trunc);
+            file << corruption;
+        }
+        verify_ok(code);
+    }
+}
+
+TEST_F(ImportFixture, cache_checks_imports) {
+    const std::string cache_dir = "./kiraz_test_cache";
+    const std::string code = "import kiraz_test_import; func f() : Integer64 { return 3; };";
+    std::filesystem::remove_all(cache_dir);
+    CompileCache cache(cache_dir);
+
+    auto compile = [&] {
+        Compiler compiler;
+        compiler.set_cache(&cache);
+        EXPECT_EQ(compiler.compile_string(code), 0);
+        return compiler.get_wasm_ctx().body().str();
+    };
+
+    /* perform */
+    auto first = compile();
+    auto second = compile();
+    /* an edited import may break the module, so it misses even when the source is the same */
+    std::ofstream(source_name) << "func norm(p: Integer64) : Integer64 { return p + p; };";
+    auto third = compile();
+
+    /* verify */
+    ASSERT_FALSE(first.empty());
+    ASSERT_EQ(second, first);
+    ASSERT_EQ(third, first);
+    auto counters = cache.get_counters();
+    ASSERT_EQ(counters.hits, 1);
+    ASSERT_EQ(counters.misses, 2);
+    ASSERT_EQ(counters.stores, 2);
+
+    std::filesystem::remove_all(cache_dir);
+}
+
+TEST_F(ImportFixture, cache_works_from_other_directories) {
+    const auto cache_dir = std::filesystem::absolute("./kiraz_test_cache_cwd").string();
+    const auto cwd = std::filesystem::current_path();
+    const std::string code = "import kiraz_test_import; func f() : Integer64 { return 3; };";
+    std::filesystem::remove_all(cache_dir);
+    std::filesystem::create_directories("./kiraz_test_cwd");
+    CompileCache cache(cache_dir);
+
+    auto compile = [&] {
+        Compiler compiler;
+        compiler.set_cache(&cache);
+        return compiler.compile_string(code);
+    };
+
+    /* perform */
+    ASSERT_EQ(compile(), 0);
+    std::filesystem::current_path("./kiraz_test_cwd");
+    /* the import can not be resolved from here, only a hit compiles */
+    auto status = compile();
+    std::filesystem::current_path(cwd);
+
+    /* verify */
+    ASSERT_EQ(status, 0);
+    ASSERT_EQ(cache.get_counters().hits, 1);
+
+    std::filesystem::remove_all(cache_dir);
+    std::filesystem::remove_all("./kiraz_test_cwd");
+}
+
+TEST(Compiler, false_literal_is_false) {
+    Compiler compiler;
+
+    /* perform */
+    auto status = compiler.compile_string(
+            "func f() : Integer64 { if (false) { return 1; }; return 2; };");
+
+    /* verify */
+    ASSERT_EQ(status, 0) << compiler.get_error();
+    ASSERT_EQ(compiler.get_wasm_ctx().body().str(),
+            "(module\n"
+            "  (func $f (export \"f\") (result i64)\n"
+            "    i64.const 2\n"
+            "    return\n"
+            "  )\n"
+            ")\n");
+}
+
+TEST(Compiler, roots_stay_bounded) {
+    Compiler compiler;
+
+    /* perform */
+    for (size_t i = 0; i < 100; ++i) {
+        compiler.compile_string(FF("func f{}() : Integer64 {{ return {}; }};", i, i));
+    }
+    compiler.compile_string("func g() : Void { h; };");
+
+    /* verify */
+    ASSERT_LE(compiler.get_parser_state().roots.size(), 2);
+    ASSERT_FALSE(Node::get_root_before());
+}
+
+TEST(CompileStats, counts_work_per_phase) {
+    Compiler compiler;
+    compiler.get_stats().set_detailed(true);
+
+    /* perform */
+    ASSERT_EQ(compiler.compile_string("func f(a: Integer64) : Integer64 { return a + 1; };"
+                                      "func main() : Integer64 { return f(2); };"),
+            0);
+
+    /* verify */
+    const auto &stats = compiler.get_stats();
+    using Phase = CompileStats::Phase;
+    ASSERT_EQ(stats.get(Phase::Parse).num_runs, 1);
+    ASSERT_EQ(stats.get(Phase::SymtabForward).num_runs, 1 + 2); // the functions, each statement
+    ASSERT_EQ(stats.get(Phase::Emit).num_runs, 1);
+    ASSERT_EQ(stats.get(Phase::Lex).num_runs, stats.num_tokens + 1);
+    ASSERT_GT(stats.get(Phase::Parse).arena_bytes, 0);
+    ASSERT_GT(stats.get(Phase::Emit).peak_rss, 0);
+    ASSERT_EQ(stats.num_compilations, 1);
+    ASSERT_GT(stats.num_nodes, 20);
+    ASSERT_GT(stats.num_lookups, 0);
+    ASSERT_EQ(stats.num_bytes_emitted, compiler.get_wasm_ctx().body().size());
+
+    CompileStats total;
+    total.merge(stats);
+    total.merge(stats);
+    ASSERT_EQ(total.num_tokens, 2 * stats.num_tokens);
+    ASSERT_NE(total.to_json().find(FF("\"tokens\":{}", 2 * stats.num_tokens)), std::string::npos);
+}
+
+TEST(ModuleInterface, decodes_on_lookup) {
+    constexpr size_t num_funcs = 1000;
+    const std::string source_name = "./kiraz_test_interface.ki";
+    const auto interface_name = ModuleInterface::get_file_name(source_name);
+
+    std::string code = "class Box { let size: Integer64; func get() : Integer64 { return 1; }; };";
+    for (size_t i = 0; i < num_funcs; ++i) {
+        code += FF("func f{}(a: Integer64) : Integer64 {{ return a + {}; }};", i, i);
+    }
+    std::ofstream(source_name) << code;
+
+    Compiler compiler;
+    ModuleInterface::Stamp stamp;
+    ASSERT_TRUE(ModuleInterface::Stamp::of(source_name, stamp));
+    ASSERT_TRUE(ModuleInterface::write(interface_name, compiler.compile_module(code), stamp));
+
+    /* perform */
+    ModuleInterface interface;
+    ASSERT_TRUE(interface.open(interface_name, stamp));
+    auto &names = SymbolTable::get_names();
+    auto func = std::dynamic_pointer_cast<ast::FunctionStatement>(interface.find(names.intern("f7")));
+    auto cls = std::dynamic_pointer_cast<ast::ClassStatement>(interface.find(names.intern("Box")));
+    auto missing = interface.find(names.intern("f1000"));
+
+    /* verify */
+    ASSERT_EQ(interface.size(), num_funcs + 1);
+    ASSERT_TRUE(func);
+    ASSERT_EQ(func->as_string(), "Func(n=Id(f7), a=FuncArgs([FArg(n=Id(a), t=Id(Integer64))]), r=Id(Integer64), s=[])");
+    ASSERT_TRUE(cls);
+    ASSERT_TRUE(cls->get_symtab()->lookup("size"));
+    ASSERT_TRUE(cls->get_symtab()->lookup("get"));
+    ASSERT_FALSE(missing);
+    ASSERT_EQ(interface.get_num_decoded(), 2);
+
+    /* a changed source invalidates the interface */
+    auto stale = stamp;
+    ++stale.size;
+    ASSERT_FALSE(ModuleInterface().open(interface_name, stale));
+
+    std::filesystem::remove(source_name);
+    std::filesystem::remove(interface_name);
+}
+
 } // namespace kiraz
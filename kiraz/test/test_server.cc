@@ -0,0 +1,64 @@
+#include <map>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <kiraz/CompileServer.h>
+
+TEST(CompileServer, answers_requests) {
+    int requests[2];
+    int responses[2];
+    ASSERT_EQ(pipe(requests), 0);
+    ASSERT_EQ(pipe(responses), 0);
+
+    std::string input = CompileServer::encode_frame(1, CompileServer::COMPILE_WAT,
+                                "func main() : Integer64 { return 1 + 2; };")
+            + CompileServer::encode_frame(2, CompileServer::COMPILE_WASM,
+                    "func main() : Integer64 { return 3; };")
+            + CompileServer::encode_frame(3, CompileServer::COMPILE_WAT,
+                    "func main() : Integer64 { return x; };")
+            + CompileServer::encode_frame(4, CompileServer::Kind('?'), "")
+            + CompileServer::encode_frame(5, CompileServer::COMPILE_WAT,
+                    "func main() : Integer64 { return 1 +; };");
+    ASSERT_EQ(write(requests[1], input.data(), input.size()), ssize_t(input.size()));
+    close(requests[1]);
+
+    /* perform */
+    ASSERT_TRUE(CompileServer(2).serve(requests[0], responses[1]));
+    close(requests[0]);
+    close(responses[1]);
+
+    std::string output;
+    char buffer[4096];
+    for (ssize_t size; (size = read(responses[0], buffer, sizeof(buffer))) > 0;) {
+        output.append(buffer, size);
+    }
+    close(responses[0]);
+
+    /* verify */
+    std::map<uint32_t, std::pair<char, std::string>> frames;
+    for (std::string_view rest = output; ! rest.empty();) {
+        ASSERT_GE(rest.size(), CompileServer::HEADER_SIZE);
+        auto get_u32 = [&rest](size_t offset) {
+            uint32_t retval = 0;
+            for (size_t i = 0; i < 4; ++i) {
+                retval |= uint32_t(uint8_t(rest[offset + i])) << (8 * i);
+            }
+            return retval;
+        };
+        auto size = get_u32(0);
+        frames[get_u32(4)] = {rest[8], std::string(rest.substr(CompileServer::HEADER_SIZE, size))};
+        rest.remove_prefix(CompileServer::HEADER_SIZE + size);
+    }
+
+    ASSERT_EQ(frames.size(), 5);
+    ASSERT_EQ(frames[1].first, CompileServer::OUTPUT_WAT);
+    ASSERT_NE(frames[1].second.find("i64.const 3"), std::string::npos);
+    ASSERT_EQ(frames[2].first, CompileServer::OUTPUT_WASM);
+    ASSERT_EQ(frames[2].second.substr(0, 4), std::string("\0asm", 4));
+    ASSERT_EQ(frames[3].first, CompileServer::DIAGNOSTICS);
+    ASSERT_NE(frames[3].second.find("'x'"), std::string::npos);
+    ASSERT_EQ(frames[4].first, CompileServer::DIAGNOSTICS);
+    ASSERT_EQ(frames[5].first, CompileServer::DIAGNOSTICS);
+    ASSERT_EQ(frames[5].second, "Parser Error at 1:37: syntax error at token: OP_SCOLON");
+}
@@ -0,0 +1,52 @@
+#include <filesystem>
+#include <fstream>
+#include <regex>
+#include <set>
+#include <sstream>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <kiraz/Compiler.h>
+#include <kiraz/Trace.h>
+
+TEST(Trace, records_spans_per_thread) {
+    const std::string trace_name = "./kiraz_test_trace.json";
+    auto compile = [] {
+        Compiler compiler;
+        EXPECT_EQ(compiler.compile_string("func main() : Integer64 { return 1; };"), 0);
+    };
+
+    /* perform */
+    Trace::clear();
+    compile();
+    ASSERT_EQ(Trace::get_num_events(), 0);
+
+    Trace::start();
+    std::thread(compile).join();
+    std::thread(compile).join();
+    Trace::stop();
+    ASSERT_TRUE(Trace::write(trace_name));
+
+    /* verify */
+    std::stringstream trace;
+    trace << std::ifstream(trace_name).rdbuf();
+    auto text = trace.str();
+    ASSERT_TRUE(text.starts_with("{\"displayTimeUnit\""));
+    for (auto name : {"parse", "check", "lower", "optimize", "emit", "symtab_forward",
+                      "symtab_ordered", "compute_stmt_type", "gen_ir"}) {
+        ASSERT_NE(text.find(FF("\"name\":\"{}\"", name)), std::string::npos) << name;
+    }
+    /* top level statements are named after themselves */
+    ASSERT_NE(text.find("\"args\":{\"detail\":\"main\"}"), std::string::npos);
+
+    std::set<std::string> tids;
+    std::regex tid_regex("\"name\":\"parse\".*?\"tid\":([0-9]+)");
+    for (std::sregex_iterator iter(text.begin(), text.end(), tid_regex), end; iter != end; ++iter) {
+        tids.insert((*iter)[1]);
+    }
+    ASSERT_EQ(tids.size(), 2);
+
+    Trace::clear();
+    std::filesystem::remove(trace_name);
+}
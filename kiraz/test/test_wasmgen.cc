@@ -17,6 +17,8 @@
 #endif
 
 // wabt
+#include <wabt/binary-reader-ir.h>
+#include <wabt/binary-reader.h>
 #include <wabt/binary-writer.h>
 #include <wabt/error-formatter.h>
 #include <wabt/validator.h>
@@ -124,6 +126,62 @@ struct WasmGenFixture : public ::testing::Test {
         ASSERT_EQ(wat, wat_expected);
     }
 
+    /**
+     * @brief verify_wasm: Verifies the binary module the wasm backend builds for the given code
+     * @param code: Kiraz source code, as a string.
+     * @param wasm_expected: Expected module bytes, only compared when not empty.
+     */
+    void verify_wasm(const std::string &code, const std::vector<uint8_t> &wasm_expected = {}) {
+        Compiler compiler;
+        compiler.set_target(Compiler::Target::Wasm);
+
+        /* perform */
+        auto ret = compiler.compile_string(code);
+
+        /* verify */
+        if (ret != 0) {
+            fmt::print("{}\n", compiler.get_error());
+            ASSERT_EQ(ret, 0);
+        }
+
+        const auto &wasm = compiler.get_wasm_binary();
+        std::string fn = ::testing::UnitTest::GetInstance()->current_test_info()->name();
+        auto fn_wasm = FF("{}.wasm", fn);
+
+        {
+            std::ofstream f;
+            f.open(fn_wasm, std::ios::out | std::ios::binary);
+            if (f.is_open()) {
+                f.write(reinterpret_cast<const char *>(wasm.data()), wasm.size());
+            }
+        }
+
+        /* wasm: read back and validate */
+        {
+            wabt::Features features;
+            wabt::Errors errors;
+            wabt::Module module;
+
+            wabt::ReadBinaryOptions read_options(features, nullptr, false, true, true);
+            if (auto result = ReadBinaryIr(fn_wasm.c_str(), wasm.data(), wasm.size(), read_options,
+                        &errors, &module);
+                    Failed(result)) {
+                FormatErrorsToFile(errors, wabt::Location::Type::Binary);
+                ASSERT_TRUE(Succeeded(result));
+            }
+
+            wabt::ValidateOptions options(features);
+            if (auto result = ValidateModule(&module, &errors, options); Failed(result)) {
+                FormatErrorsToFile(errors, wabt::Location::Type::Binary);
+                ASSERT_TRUE(Succeeded(result));
+            }
+        }
+
+        if (! wasm_expected.empty()) {
+            ASSERT_EQ(wasm, wasm_expected);
+        }
+    }
+
 #ifdef KIRAZ_HAVE_MOZJS
     /**
      * @brief verify_output: Verifies the wat output of the given kiraz module
@@ -302,6 +360,214 @@ TEST_F(WasmGenFixture, if_simple_true) {
     );
 }
 
+TEST_F(WasmGenFixture, wasm_func_add) {
+    verify_wasm( //
+            "func add(a: Integer64, b: Integer64) : Integer64 { return a + b; };",
+            {
+                    0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00, // magic, version
+                    0x01, 0x07, 0x01, 0x60, 0x02, 0x7e, 0x7e, 0x01, 0x7e, // (i64, i64) -> i64
+                    0x03, 0x02, 0x01, 0x00, // add: type 0
+                    0x07, 0x07, 0x01, 0x03, 0x61, 0x64, 0x64, 0x00, 0x00, // export "add"
+                    0x0a, 0x0a, 0x01, 0x08, 0x00, // add: no locals
+                    0x20, 0x00, 0x20, 0x01, 0x7c, 0x0f, 0x0b, // a + b, return
+            });
+}
+
+TEST_F(WasmGenFixture, wasm_control_flow) {
+    verify_wasm( //
+            "func fact(n: Integer64) : Integer64 {"
+            "   let r = 1; let i = 1;"
+            "   while (i <= n) { r = r * i; i = i + 1; };"
+            "   return r; };"
+            "func sign(x: Integer64) : Integer64 {"
+            "   if (x < 0) { return -1; } else if (x == 0) { return 0; };"
+            "   return fact(1); };"
+            "func main() : Void { let t = true; if (and(t, not(false))) { let m = -5; sign(m); }; };");
+}
+
+TEST_F(WasmGenFixture, wat_func_add) {
+    verify_wat( //
+            "func add(a: Integer64, b: Integer64) : Integer64 { return a + b; };",
+            "(module\n"
+            "  (func $add (export \"add\") (param $a i64) (param $b i64) (result i64)\n"
+            "    local.get $a\n"
+            "    local.get $b\n"
+            "    i64.add\n"
+            "    return\n"
+            "  )\n"
+            ")\n");
+}
+
+TEST_F(WasmGenFixture, wat_globals_and_shadowing) {
+    verify_wat( //
+            "let g = -2;"
+            "func f(x: Integer64) : Void { let x = x + g; g = x; };",
+            "(module\n"
+            "  (global $g (mut i64) (i64.const -2))\n"
+            "  (func $f (export \"f\") (param $x i64)\n"
+            "    (local $x.1 i64)\n"
+            "    local.get $x\n"
+            "    global.get $g\n"
+            "    i64.add\n"
+            "    local.set $x.1\n"
+            "    local.get $x.1\n"
+            "    global.set $g\n"
+            "  )\n"
+            ")\n");
+}
+
+TEST_F(WasmGenFixture, wat_constant_folding) {
+    verify_wat( //
+            "let scale = 2 * 3 + 1;"
+            "func f(x: Integer64) : Integer64 {"
+            "   let k = scale * 10;"
+            "   while (k < 0) { x = x - 1; };"
+            "   if (k > 50) { return x + k; };"
+            "   return 0; };",
+            "(module\n"
+            "  (func $f (export \"f\") (param $x i64) (result i64)\n"
+            "    local.get $x\n"
+            "    i64.const 70\n"
+            "    i64.add\n"
+            "    return\n"
+            "  )\n"
+            ")\n");
+}
+
+TEST_F(WasmGenFixture, wat_constant_folding_keeps_traps) {
+    verify_wat( //
+            "func f() : Integer64 { let a = 1; a = a / 0; return a; };",
+            "(module\n"
+            "  (func $f (export \"f\") (result i64)\n"
+            "    (local $a i64)\n"
+            "    i64.const 1\n"
+            "    local.set $a\n"
+            "    local.get $a\n"
+            "    i64.const 0\n"
+            "    i64.div_s\n"
+            "    local.set $a\n"
+            "    local.get $a\n"
+            "    return\n"
+            "  )\n"
+            ")\n");
+}
+
+TEST_F(WasmGenFixture, wat_dead_functions) {
+    verify_wat( //
+            "let unused = 5; let used = 7;"
+            "func helper(x: Integer64) : Integer64 { return x * used; };"
+            "func dead(x: Integer64) : Integer64 { return x + unused; };"
+            "func main() : Integer64 { let a = 6; return helper(a); };",
+            "(module\n"
+            "  (func $helper (param $x i64) (result i64)\n"
+            "    local.get $x\n"
+            "    i64.const 7\n"
+            "    i64.mul\n"
+            "    return\n"
+            "  )\n"
+            "  (func $main (export \"main\") (result i64)\n"
+            "    i64.const 6\n"
+            "    call $helper\n"
+            "    return\n"
+            "  )\n"
+            ")\n");
+}
+
+TEST(DeadCodeElimination, entry_points) {
+    const std::string code = "func dead(x: Integer64) : Integer64 { return x + 5; };"
+                             "func entry() : Integer64 { return dead(1); };"
+                             "func main() : Void {};";
+    {
+        Compiler compiler;
+        compiler.set_entry_points({"entry"});
+        ASSERT_EQ(compiler.compile_string(code), 0) << compiler.get_error();
+        ASSERT_EQ(compiler.get_wasm_ctx().body().str(),
+                "(module\n"
+                "  (func $dead (param $x i64) (result i64)\n"
+                "    local.get $x\n"
+                "    i64.const 5\n"
+                "    i64.add\n"
+                "    return\n"
+                "  )\n"
+                "  (func $entry (export \"entry\") (result i64)\n"
+                "    i64.const 1\n"
+                "    call $dead\n"
+                "    return\n"
+                "  )\n"
+                ")\n");
+    }
+    {
+        Compiler compiler;
+        compiler.set_entry_points({"missing"});
+        ASSERT_EQ(compiler.compile_string(code), 2);
+        ASSERT_EQ(compiler.get_error(),
+                "Code Generation Error: Entry point 'missing' is not defined");
+    }
+}
+
+TEST(Module, remove_unused_globals_keeps_initializer_sources) {
+    Compiler compiler;
+    auto &names = compiler.get_parser_state().names;
+    using ir::Opcode;
+
+    ir::Module module;
+    module.globals.push_back({names.intern("unused"), {{Opcode::Const, ir::Type::I64, 5}}});
+    module.globals.push_back({names.intern("a"), {{Opcode::Const, ir::Type::I64, 1}}});
+    module.globals.push_back({names.intern("b"),
+            {{Opcode::GlobalGet, ir::Type::I64, 1}, {Opcode::Const, ir::Type::I64, 1},
+                    {Opcode::Add, ir::Type::I64}}});
+    auto &func = module.funcs.emplace_back();
+    func.name = names.intern("f");
+    func.has_result = true;
+    func.body = {{Opcode::GlobalGet, ir::Type::I64, 2}, {Opcode::Return}};
+
+    /* perform */
+    module.remove_unused_globals();
+
+    /* verify */
+    ASSERT_EQ(module.globals.size(), 2);
+    ASSERT_EQ(module.globals[0].name.str(), "a");
+    ASSERT_EQ(module.globals[1].name.str(), "b");
+    ASSERT_EQ(module.globals[1].init[0].imm, 0);
+    ASSERT_EQ(module.funcs[0].body[0].imm, 1);
+}
+
+TEST(PassManager, runs_passes_in_order_and_times_them) {
+    struct RecordPass : ir::Pass {
+        RecordPass(const char *n, std::vector<std::string> &o) : name(n), order(o) {}
+
+        const char *get_name() const override { return name; }
+        void run(ir::Module &module) override {
+            order.push_back(name);
+            num_funcs = module.funcs.size();
+        }
+
+        const char *name;
+        std::vector<std::string> &order;
+        size_t num_funcs = 0;
+    };
+
+    std::vector<std::string> order;
+    Compiler compiler;
+    auto base = compiler.get_passes().get_num_passes();
+    auto &first = compiler.get_passes().add<RecordPass>("first", order);
+    compiler.get_passes().add<RecordPass>("second", order);
+
+    ASSERT_EQ(compiler.compile_string("func f() : Void {}; func g() : Void {};"), 0)
+            << compiler.get_error();
+
+    ASSERT_EQ(order, std::vector<std::string>({"first", "second"}));
+    ASSERT_EQ(first.num_funcs, 2);
+
+    const auto &timings = compiler.get_passes().get_timings();
+    ASSERT_EQ(timings.size(), base + 2);
+    ASSERT_STREQ(timings[base].name, "first");
+    ASSERT_STREQ(timings[base + 1].name, "second");
+    for (const auto &timing : timings) {
+        ASSERT_EQ(timing.num_runs, 1);
+    }
+}
+
 } // namespace kiraz
 
 int main(int argc, char **argv) {
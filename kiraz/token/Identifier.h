@@ -1,13 +1,14 @@
 #ifndef KIRAZ_TOKEN_IDENTIFIER_H
 #define KIRAZ_TOKEN_IDENTIFIER_H
 
+#include <kiraz/Interner.h>
 #include <kiraz/Token.h>
 
 namespace token {
 
 class Identifier : public Token {
 public:
-    Identifier(std::string_view value) 
+    Identifier(Symbol value) 
         : Token(IDENTIFIER), m_value(value) {}
     virtual ~Identifier() = default;
 
@@ -20,7 +21,7 @@ public:
     void print() {fmt::print("{}\n", as_string());}
 
 private:
-    std::string m_value;
+    Symbol m_value;
 };
 
 }
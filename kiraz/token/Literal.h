@@ -46,10 +46,9 @@ public:
 
     auto get_value() const {return m_value;}
 
-private:
-    int m_id;
-    std::string m_value;
-
+    /**
+     * @brief format_string: Strips the quotes of a string literal and resolves its escapes.
+     */
     static std::string format_string(std::string_view input) {
         std::string result;
 
@@ -76,6 +75,10 @@ private:
         }
         return result;
     }
+
+private:
+    int m_id;
+    std::string m_value;
 };
 
 }
@@ -1,4 +1,3 @@
 
-extern "C" int yylex(void);
-#define YY_DECL int yylex(void)
+#include "main.h"
 #include <_lexer_gen.hpp>
@@ -1,7 +1,17 @@
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
+#include <thread>
 
 #include "lexer.hpp"
 #include "main.h"
@@ -9,7 +19,11 @@
 #include <iostream>
 #include "kiraz/Compiler.h"
 
+#include <kiraz/CompileCache.h>
+#include <kiraz/CompileServer.h>
+#include <kiraz/JobPool.h>
 #include <kiraz/Node.h>
+#include <kiraz/Trace.h>
 
 extern int yydebug;
 
@@ -23,12 +37,54 @@ enum Mode {
     MODE_FILE,
     MODE_TEXT,
     MODE_HELP,
+    MODE_JOBS,
+    MODE_WASM,
 };
 
+/* Set by --cache-dir and --no-cache, the cache is created on first use */
+static std::string s_cache_dir;
+static bool s_no_cache = false;
+
+static CompileCache *get_cache() {
+    static std::unique_ptr<CompileCache> cache;
+    if (! cache && ! s_no_cache && ! s_cache_dir.empty()) {
+        cache = std::make_unique<CompileCache>(s_cache_dir);
+    }
+    return s_no_cache ? nullptr : cache.get();
+}
+
+/* Set by --time-report and --stats */
+enum class StatsFormat {
+    None,
+    Table,
+    Json,
+};
+static StatsFormat s_stats_format = StatsFormat::None;
+
+static void configure(Compiler &compiler) {
+    compiler.set_cache(get_cache());
+    compiler.get_stats().set_detailed(s_stats_format != StatsFormat::None);
+}
+
+/* Statistics go to stderr, stdout may carry the output */
+static void report_stats(const CompileStats &stats) {
+    switch (s_stats_format) {
+    case StatsFormat::None:
+        break;
+    case StatsFormat::Table:
+        std::cerr << stats.to_table();
+        break;
+    case StatsFormat::Json:
+        std::cerr << stats.to_json() << std::endl;
+        break;
+    }
+}
+
 static int test(std::string_view str) {
-    auto buffer = yy_scan_string(str.data());
-    auto ret = yyparse();
-    yy_delete_buffer(buffer);
+    Compiler compiler;
+    auto buffer = yy_scan_string(str.data(), compiler.get_scanner());
+    auto ret = yyparse(compiler.get_scanner());
+    yy_delete_buffer(buffer, compiler.get_scanner());
 
     if (Node::current_root()) {
         fmt::print("{}\n", Node::current_root()->as_string());
@@ -40,7 +96,17 @@ static int test(std::string_view str) {
 static int usage(int argc, char **argv) {
     fmt::print("Usage: {} -s [string to parse] ....\n", argv[0]);
     fmt::print("       {} -f [file to parse] ....\n", argv[0]);
+    fmt::print("       {} -j [jobs] [file.ki | @filelist] ....\n", argv[0]);
+    fmt::print("       {} -w [file.ki] Write the binary module to file.wasm\n", argv[0]);
+    fmt::print("       {} --serve [socket] Answer compile requests on stdin or a Unix socket\n",
+            argv[0]);
     fmt::print("       {} -h Show this help\n", argv[0]);
+    fmt::print("Options, before the mode:\n");
+    fmt::print("       --cache-dir [dir] Reuse the output of unchanged inputs stored in dir\n");
+    fmt::print("       --no-cache Compile every input, ignoring --cache-dir\n");
+    fmt::print("       --time-report Print the time and memory spent per phase to stderr\n");
+    fmt::print("       --stats=[table|json] Same as --time-report, in the given format\n");
+    fmt::print("       --trace=[file] Write a Chrome trace of the compilation to file\n");
 
     return ERR;
 }
@@ -54,32 +120,237 @@ static int handle_mode_text(std::string_view arg) {
 }
 
 static int handle_mode_file(std::string_view arg) {
-    std::ifstream file("../" + std::string(arg), std::ios::in);
-    if (!file.is_open()) {
-        std::cerr << "Error: Unable to open file " << arg << std::endl;
+    Compiler compiler;
+    configure(compiler);
+    int result = compiler.compile_file("../" + std::string(arg));
+    report_stats(compiler.get_stats());
+
+    if (!compiler.get_error().empty()) {
+        std::cerr << compiler.get_error() << std::endl;
         return ERR;
     }
 
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    file.close();
+    std::cout << compiler.get_wasm_ctx().body() << std::endl;
+
+    return result;
+}
 
-    std::string content = buffer.str();
+static int handle_mode_wasm(std::string_view arg) {
     Compiler compiler;
-    int result = compiler.compile_string(content);
+    compiler.set_target(Compiler::Target::Wasm);
+    configure(compiler);
+    int result = compiler.compile_file(std::string(arg));
+    report_stats(compiler.get_stats());
 
     if (!compiler.get_error().empty()) {
         std::cerr << compiler.get_error() << std::endl;
         return ERR;
     }
+    if (result != 0) {
+        return result;
+    }
+
+    auto wasm_name = std::filesystem::path(arg).replace_extension(".wasm");
+    std::ofstream wasm(wasm_name, std::ios::out | std::ios::binary);
+    const auto &binary = compiler.get_wasm_binary();
+    if (! wasm.write(reinterpret_cast<const char *>(binary.data()), binary.size())) {
+        std::cerr << "Error: Unable to write " << wasm_name.string() << std::endl;
+        return ERR;
+    }
+
+    return OK;
+}
 
-    std::cout << compiler.get_wasm_ctx().body().str() << std::endl;
+struct BatchResult {
+    int status = 0;
+    std::string error;
+    double seconds = 0;
+    CompileStats stats;
+};
+
+static bool collect_batch_inputs(const std::vector<std::string> &args,
+        std::vector<std::string> &files) {
+    for (const auto &arg : args) {
+        if (! arg.starts_with('@')) {
+            files.push_back(arg);
+            continue;
+        }
 
+        std::ifstream list(arg.substr(1));
+        if (! list.is_open()) {
+            std::cerr << "Error: Unable to open file list " << arg.substr(1) << std::endl;
+            return false;
+        }
+
+        std::string line;
+        while (std::getline(list, line)) {
+            if (! line.empty()) {
+                files.push_back(line);
+            }
+        }
+    }
+
+    return true;
+}
+
+static BatchResult compile_batch_file(const std::string &file_name, CompileCache *cache) {
+    BatchResult result;
+    auto start = std::chrono::steady_clock::now();
+
+    Compiler compiler;
+    compiler.set_cache(cache);
+    compiler.get_stats().set_detailed(s_stats_format != StatsFormat::None);
+    result.status = compiler.compile_file(file_name);
+    result.error = compiler.get_error();
+    if (result.status != 0 && result.error.empty()) {
+        result.error = FF("Compilation failed with status {}", result.status);
+    }
+
+    if (result.status == 0) {
+        auto wat_name = std::filesystem::path(file_name).replace_extension(".wat").string();
+        Trace::Span span("write_file", wat_name);
+        std::ofstream wat(wat_name, std::ios::out | std::ios::binary);
+        if (! wat.is_open()) {
+            result.status = ERR;
+            result.error = FF("Unable to write {}", wat_name);
+        }
+        else {
+            compiler.get_wasm_ctx().body().write_to(wat);
+        }
+    }
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+                             .count();
+    result.stats = compiler.get_stats();
     return result;
 }
 
+/* Upper bound of -j per hardware thread */
+static constexpr size_t MAX_JOBS_PER_CPU = 4;
+
+/* strtoul takes a sign and wraps negative numbers around, so only plain digits are accepted */
+static bool parse_jobs(const char *text, size_t &value) {
+    if (! std::isdigit(static_cast<unsigned char>(*text))) {
+        return false;
+    }
+
+    char *end = nullptr;
+    errno = 0;
+    auto count = std::strtoul(text, &end, 10);
+    if (errno || *end != '\0' || count == 0) {
+        return false;
+    }
+    value = count;
+    return true;
+}
+
+static int handle_mode_batch(size_t num_jobs, const std::vector<std::string> &args) {
+    std::vector<std::string> files;
+    if (! collect_batch_inputs(args, files)) {
+        return ERR;
+    }
+
+    if (files.empty()) {
+        std::cerr << "Error: No input files" << std::endl;
+        return ERR;
+    }
+
+    // compiling is CPU bound, more workers than a few per core only cost memory and threads
+    auto max_jobs = std::max<size_t>(1, std::thread::hardware_concurrency()) * MAX_JOBS_PER_CPU;
+    num_jobs = std::min({num_jobs, files.size(), max_jobs});
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<BatchResult> results(files.size());
+    auto cache = get_cache();
+    {
+        JobPool pool(num_jobs);
+        for (size_t i = 0; i < files.size(); ++i) {
+            pool.submit([&files, &results, cache, i] {
+                results[i] = compile_batch_file(files[i], cache);
+            });
+        }
+        pool.wait();
+    }
+
+    auto wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    size_t failed = 0;
+    double total = 0;
+    CompileStats stats;
+    for (size_t i = 0; i < files.size(); ++i) {
+        total += results[i].seconds;
+        stats.merge(results[i].stats);
+        if (results[i].status != 0) {
+            ++failed;
+            std::cerr << files[i] << ": " << results[i].error << std::endl;
+        }
+    }
+
+    fmt::print("Compiled {} of {} files with {} jobs in {:.3f}s (sum of compile times {:.3f}s)\n",
+            files.size() - failed, files.size(), num_jobs, wall, total);
+    if (cache) {
+        auto counters = cache->get_counters();
+        fmt::print("Cache {}: {} hits, {} misses, {} stored, {} evicted\n", cache->get_dir(),
+                counters.hits, counters.misses, counters.stores, counters.evictions);
+    }
+    report_stats(stats);
+
+    return failed ? ERR : OK;
+}
+
+/* Set by --trace, written however main returns */
+static std::string s_trace_file;
+
+static void write_trace() {
+    if (! s_trace_file.empty() && ! Trace::write(s_trace_file)) {
+        std::cerr << "Error: Unable to write " << s_trace_file << ": " << std::strerror(errno)
+                  << std::endl;
+    }
+}
+
+static int handle_mode_serve(const std::string &socket_path) {
+#ifndef _WIN32
+    // a client that goes away must not take the server with it
+    std::signal(SIGPIPE, SIG_IGN);
+
+    // a server runs until it is killed, so a thread waits for that to write the trace. The
+    // signals are blocked before the workers start, so they inherit the mask and leave them to it.
+    if (! s_trace_file.empty()) {
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+        std::thread([signals] {
+            int signal = 0;
+            sigwait(&signals, &signal);
+            Trace::stop();
+            write_trace();
+            std::_Exit(128 + signal);
+        }).detach();
+    }
+#endif
+
+    CompileServer server(std::thread::hardware_concurrency(), get_cache());
+    if (socket_path.empty()) {
+        return server.serve(0, 1) ? OK : ERR;
+    }
+
+    if (! server.listen(socket_path)) {
+        std::cerr << "Error: Unable to listen on " << socket_path << ": " << std::strerror(errno)
+                  << std::endl;
+    }
+    return ERR;
+}
+
+struct TraceWriter {
+    ~TraceWriter() { write_trace(); }
+};
+
 int main(int argc, char **argv) {
     yydebug = 0;
+    TraceWriter trace_writer;
 
     static Mode mode = MODE_UNKNOWN;
 
@@ -88,8 +359,6 @@ int main(int argc, char **argv) {
     }
 
     for (auto i = 1; i < argc; ++i) {
-        Node::reset_root();
-
         std::string_view arg(argv[i]);
 
         if (mode == MODE_UNKNOWN) {
@@ -107,6 +376,46 @@ int main(int argc, char **argv) {
                 mode = MODE_HELP;
                 continue;
             }
+
+            if (arg == "-j") {
+                mode = MODE_JOBS;
+                continue;
+            }
+
+            if (arg == "-w") {
+                mode = MODE_WASM;
+                continue;
+            }
+
+            if (arg == "--cache-dir" && i + 1 < argc) {
+                s_cache_dir = argv[++i];
+                continue;
+            }
+
+            if (arg == "--no-cache") {
+                s_no_cache = true;
+                continue;
+            }
+
+            if (arg == "--time-report" || arg == "--stats" || arg == "--stats=table") {
+                s_stats_format = StatsFormat::Table;
+                continue;
+            }
+
+            if (arg == "--stats=json") {
+                s_stats_format = StatsFormat::Json;
+                continue;
+            }
+
+            if (arg.starts_with("--trace=")) {
+                s_trace_file = arg.substr(std::string_view("--trace=").size());
+                Trace::start();
+                continue;
+            }
+
+            if (arg == "--serve") {
+                return handle_mode_serve(i + 1 < argc ? argv[i + 1] : "");
+            }
         }
 
         switch (mode) {
@@ -125,6 +434,21 @@ int main(int argc, char **argv) {
                 return ret;
             }
             break;
+
+        case MODE_WASM:
+            if (auto ret = handle_mode_wasm(argv[i]); ret != OK) {
+                return ret;
+            }
+            break;
+
+        case MODE_JOBS: {
+            size_t num_jobs;
+            if (! parse_jobs(argv[i], num_jobs)) {
+                std::cerr << "Error: Invalid number of jobs " << argv[i] << std::endl;
+                return ERR;
+            }
+            return handle_mode_batch(num_jobs, {argv + i + 1, argv + argc});
+        }
         }
 
         mode = MODE_UNKNOWN;
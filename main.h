@@ -1,4 +1,3 @@
-
 #pragma once
 
 #include <memory>
@@ -7,7 +6,9 @@
 #include <fmt/ranges.h>
 
 class Node;
-extern "C" int yylex(void);
-#define YY_DECL int yylex(void)
+struct ParserState;
 #define YYSTYPE std::shared_ptr<Node>
 #include "parser.hpp"
+
+int yylex(YYSTYPE *yylval_param, yyscan_t yyscanner);
+#define YY_DECL int yylex(YYSTYPE *yylval_param, yyscan_t yyscanner)
@@ -16,15 +16,32 @@
 #include <kiraz/token/Literal.h>
 #include <kiraz/token/Operator.h>
 
-int yyerror(const char *msg);
-extern std::shared_ptr<Token> curtoken;
-extern int yylineno;
+#include <kiraz/Compiler.h>
+#include <kiraz/ParserState.h>
 
-std::shared_ptr<ast::ParameterList> parameters = nullptr;
-std::vector<std::shared_ptr<ast::Parameter>> param_vector;
+int yyerror(yyscan_t scanner, const char *msg);
+
+static ParserState &state(yyscan_t scanner) {
+    return *yyget_extra(scanner);
+}
+
+/* Lets the statistics tell scanning from parsing, defined after the grammar */
+static int yylex_timed(YYSTYPE *yylval_param, yyscan_t scanner);
+#define yylex yylex_timed
 
 %}
 
+%code requires {
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void *yyscan_t;
+#endif
+}
+
+%define api.pure full
+%lex-param   { yyscan_t scanner }
+%parse-param { yyscan_t scanner }
+
 %token    IDENTIFIER
 
 %token    OP_RETURNS
@@ -87,9 +104,32 @@ prog
     ;
 
 stmts
-    : stmt stmts  { $$ = Node::add<ast::StatementList>($1, $2); }
-    | /* empty */ { $$ = nullptr; }
-    | expr        { $$ = $1; }
+    : stmt_list      { $$ = $1; }
+    | stmt_list expr
+    {
+        if ($1) {
+            std::static_pointer_cast<ast::StatementList>($1)->append($2);
+            $$ = $1;
+        }
+        else {
+            $$ = $2;
+        }
+    }
+    ;
+
+/* Left recursive, so the parser stack stays flat however long the sequence is */
+stmt_list
+    : /* empty */    { $$ = nullptr; }
+    | stmt_list stmt
+    {
+        if ($1) {
+            std::static_pointer_cast<ast::StatementList>($1)->append($2);
+            $$ = $1;
+        }
+        else {
+            $$ = Node::add<ast::StatementList>($2);
+        }
+    }
     ;
 
 stmt
@@ -131,6 +171,8 @@ func_stmt
     : KW_FUNC identifier OP_LPAREN param_list OP_RPAREN type_decl OP_LBRACE stmts OP_RBRACE OP_SCOLON
     {
         auto func = Node::add<ast::FunctionStatement>($2, $4, $6, $8);
+        auto &parameters = state(scanner).parameters;
+        auto &param_vector = state(scanner).param_vector;
         if(func) {
             if(parameters) {
                 parameters->set_stmt(func);
@@ -148,14 +190,20 @@ param_list
     : /* empty */                   { $$ = nullptr; }
     | param
     { 
-        auto params = Node::add<ast::ParameterList>($1, nullptr);
-        parameters = params;
+        auto params = Node::add<ast::ParameterList>($1);
+        state(scanner).parameters = params;
         $$ = params;
     }
     | param_list OP_COMMA param 
     { 
-        auto params = Node::add<ast::ParameterList>($1, $3);
-        parameters = params;
+        auto params = std::static_pointer_cast<ast::ParameterList>($1);
+        if (params) {
+            params->append($3);
+        }
+        else {
+            params = Node::add<ast::ParameterList>($3);
+        }
+        state(scanner).parameters = params;
         $$ = params;
     }
     ;
@@ -164,13 +212,13 @@ param
     : identifier type_decl
     {
         auto param = Node::add<ast::Parameter>($1, $2);
-        param_vector.push_back(param);
+        state(scanner).param_vector.push_back(param);
         $$ = param;
     }
     | atom
     {
         auto param = Node::add<ast::Parameter>($1, nullptr);
-        param_vector.push_back(param);
+        state(scanner).param_vector.push_back(param);
         $$ = param;
     }
     ;
@@ -220,6 +268,21 @@ assign_stmt
             $3  // Right-hand side expression
         );
     }
+    | builtin_name OP_ASSIGN expr OP_SCOLON
+    {
+        $$ = Node::add<ast::AssignmentStatement>($1, $3);
+    }
+    | builtin_name OP_ASSIGN builtin_name OP_SCOLON
+    {
+        $$ = Node::add<ast::AssignmentStatement>($1, $3);
+    }
+    ;
+
+/* The builtin functions as plain names, only parsed so the checker can reject assigning them */
+builtin_name
+    : OP_AND  { $$ = Node::add<ast::Identifier>(state(scanner).names.intern("and")); }
+    | OP_OR   { $$ = Node::add<ast::Identifier>(state(scanner).names.intern("or")); }
+    | OP_NOT  { $$ = Node::add<ast::Identifier>(state(scanner).names.intern("not")); }
     ;
 
 call_expr
@@ -312,7 +375,7 @@ negative
     : OP_MINUS atom           { $$ = Node::add<ast::SignedNode>(OP_MINUS, $2); }
     | OP_MINUS OP_MINUS atom  
     {
-        yyerror("Invalid use of multiple negation operators"); 
+        yyerror(scanner, "Invalid use of multiple negation operators"); 
         Node::reset_root();
         YYERROR;
     }
@@ -321,30 +384,50 @@ negative
 
 atom
     : identifier               { $$ = $1; }
-    | L_INTEGER                { $$ = Node::add<ast::Integer>(curtoken); }
-    | L_STRING                 { $$ = Node::add<ast::String>(curtoken); }
-    | L_TRUE                   { $$ = Node::add<ast::Boolean>(L_TRUE); }
-    | L_FALSE                  { $$ = Node::add<ast::Boolean>(L_FALSE); }
+    | L_INTEGER                { $$ = Node::add<ast::Integer>(state(scanner).token.integer); }
+    | L_STRING                 { $$ = Node::add<ast::String>(state(scanner).token.text); }
+    | L_TRUE                   { $$ = Node::add<ast::Boolean>(true); }
+    | L_FALSE                  { $$ = Node::add<ast::Boolean>(false); }
     | OP_LPAREN expr OP_RPAREN { $$ = $2; }
     ;
 
 identifier
-    : IDENTIFIER               { $$ = Node::add<ast::Identifier>(curtoken); }
+    : IDENTIFIER               { $$ = Node::add<ast::Identifier>(state(scanner).token.name); }
     ;
 
 %%
 
-int yyerror(const char *s) {
-    if (curtoken) {
-        fmt::print("** Parser Error at {}:{} at token: {}\n",
-            yylineno, Token::colno, curtoken->as_string());
+#undef yylex
+
+static int yylex_timed(YYSTYPE *yylval_param, yyscan_t scanner) {
+    auto stats = state(scanner).stats;
+    if (! stats || ! stats->is_detailed()) {
+        return yylex(yylval_param, scanner);
     }
-    else {
-        fmt::print("** Parser Error at {}:{}, null token\n",
-            yylineno, Token::colno);
+
+    auto prev = stats->enter(CompileStats::Phase::Lex);
+    auto retval = yylex(yylval_param, scanner);
+    stats->enter(prev, false);
+    return retval;
+}
+
+int yyerror(yyscan_t scanner, const char *s) {
+    auto &st = state(scanner);
+
+    // the first error is the one that matters, the ones after it follow from it
+    auto compiler = Compiler::current();
+    if (compiler->get_error().empty()) {
+        if (st.token.kind) {
+            compiler->set_error(FF("Parser Error at {}:{}: {} at token: {}",
+                yyget_lineno(scanner), st.colno, s, Token::from_lexeme(st.token)->as_string()));
+        }
+        else {
+            compiler->set_error(FF("Parser Error at {}:{}: {}, null token",
+                yyget_lineno(scanner), st.colno, s));
+        }
     }
 
-    Token::colno = 0;
+    st.colno = 0;
     Node::reset_root();
 
     return 1;
@@ -19,7 +19,7 @@ include(GoogleTest)
 
 # test_parser
 add_executable(test_parser kiraz/test/test_parser.cc)
-target_link_libraries(test_parser kiraz GTest::gtest_main ${FLEX_LIBRARIES})
+target_link_libraries(test_parser kiraz GTest::gtest_main ${FLEX_LIBRARIES} Threads::Threads)
 gtest_discover_tests(test_parser)
 
 # test_semantics
@@ -27,6 +27,104 @@ add_executable(test_semantics kiraz/test/test_semantics.cc)
 target_link_libraries(test_semantics kiraz GTest::gtest_main ${FLEX_LIBRARIES})
 gtest_discover_tests(test_semantics)
 
+# test_cache, test_jobpool, ...: one target per infrastructure component
+foreach(name cache jobpool mappedfile outputbuffer server trace)
+    add_executable(test_${name} kiraz/test/test_${name}.cc)
+    target_link_libraries(test_${name} kiraz GTest::gtest_main ${FLEX_LIBRARIES} Threads::Threads)
+    gtest_discover_tests(test_${name})
+endforeach()
+
+# kirazc -j: runs on a copy of the inputs, every input that compiles gets a .wat next to it
+set(BATCH_DIR ${CMAKE_CURRENT_BINARY_DIR}/batch)
+file(COPY kiraz/test/batch/ DESTINATION ${BATCH_DIR})
+
+add_test(NAME kirazc_batch_reports_in_input_order
+    COMMAND kirazc -j 4 @inputs.txt WORKING_DIRECTORY ${BATCH_DIR})
+set_tests_properties(kirazc_batch_reports_in_input_order PROPERTIES
+    PASS_REGULAR_EXPRESSION "b\\.ki: Error[^\n]*MissingB[^\n]*\n+d\\.ki: Error[^\n]*MissingD")
+
+add_test(NAME kirazc_batch_counts_failures
+    COMMAND kirazc -j 4 a.ki b.ki c.ki d.ki WORKING_DIRECTORY ${BATCH_DIR})
+set_tests_properties(kirazc_batch_counts_failures PROPERTIES
+    PASS_REGULAR_EXPRESSION "Compiled 2 of 4 files with 4 jobs")
+
+add_test(NAME kirazc_batch_clamps_jobs
+    COMMAND kirazc -j 100000 a.ki c.ki WORKING_DIRECTORY ${BATCH_DIR})
+set_tests_properties(kirazc_batch_clamps_jobs PROPERTIES
+    PASS_REGULAR_EXPRESSION "Compiled 2 of 2 files with 2 jobs")
+
+add_test(NAME kirazc_batch_fails_with_errors
+    COMMAND kirazc -j 4 a.ki b.ki WORKING_DIRECTORY ${BATCH_DIR})
+set_tests_properties(kirazc_batch_fails_with_errors PROPERTIES WILL_FAIL TRUE)
+
+foreach(jobs 0 -1 2x 99999999999999999999999)
+    add_test(NAME kirazc_batch_rejects_jobs_${jobs}
+        COMMAND kirazc -j ${jobs} a.ki WORKING_DIRECTORY ${BATCH_DIR})
+    set_tests_properties(kirazc_batch_rejects_jobs_${jobs} PROPERTIES
+        PASS_REGULAR_EXPRESSION "Invalid number of jobs")
+endforeach()
+
+# kirazc -w: the binary backend runs in node where it is installed, wabt is not needed for these
+find_program(NODE_EXECUTABLE node)
+
+if (NODE_EXECUTABLE)
+    set(NODE_DIR ${CMAKE_CURRENT_BINARY_DIR}/node)
+    file(COPY kiraz/test/node/ DESTINATION ${NODE_DIR})
+
+    add_test(NAME kirazc_wasm_writes_module
+        COMMAND kirazc -w fact.ki WORKING_DIRECTORY ${NODE_DIR})
+    set_tests_properties(kirazc_wasm_writes_module PROPERTIES FIXTURES_SETUP wasm_module)
+
+    foreach(call "fact;5;120" "sign;-3;-1" "sign;0;0")
+        list(GET call 0 func)
+        list(GET call 1 arg)
+        list(GET call 2 result)
+        add_test(NAME kirazc_wasm_runs_${func}_${arg}
+            COMMAND ${NODE_EXECUTABLE} run_wasm.js fact.wasm ${func} ${arg}
+            WORKING_DIRECTORY ${NODE_DIR})
+        set_tests_properties(kirazc_wasm_runs_${func}_${arg} PROPERTIES
+            FIXTURES_REQUIRED wasm_module
+            PASS_REGULAR_EXPRESSION "${func}\\(${arg}\\) = ${result}\n")
+    endforeach()
+endif()
+
+# test_perf: compile time regression gate, registered with -DKIRAZ_PERF_TESTS=ON and run with
+# ctest -L perf. It is built either way, so it keeps compiling.
+option(KIRAZ_PERF_TESTS "Register the perf tests, which are kept out of the default run" FALSE)
+
+set(PERF_CORPUS_DIR ${CMAKE_CURRENT_BINARY_DIR}/perf)
+set(PERF_CORPUS_FILES)
+
+function(add_perf_corpus name)
+    set(output ${PERF_CORPUS_DIR}/${name}.ki)
+    add_custom_command(
+        OUTPUT  ${output}
+        COMMAND ${CMAKE_COMMAND} -E make_directory ${PERF_CORPUS_DIR}
+        COMMAND kiraz_gen ${ARGN} ${output}
+        DEPENDS kiraz_gen
+        COMMENT "Generating the ${name} perf corpus"
+    )
+    set(PERF_CORPUS_FILES ${PERF_CORPUS_FILES} ${output} PARENT_SCOPE)
+endfunction()
+
+# changing a corpus invalidates its figures in kiraz/test/perf_baseline.txt
+add_perf_corpus(funcs --seed=1 --funcs=1500 --classes=0)
+add_perf_corpus(classes --seed=2 --funcs=10 --classes=3000 --inherit=300)
+add_perf_corpus(nested --seed=3 --funcs=50 --nesting=16 --lets=32 --expr=48)
+add_custom_target(perf_corpora DEPENDS ${PERF_CORPUS_FILES})
+
+add_executable(test_perf kiraz/test/test_perf.cc)
+target_link_libraries(test_perf kiraz GTest::gtest_main ${FLEX_LIBRARIES})
+target_compile_definitions(test_perf PRIVATE
+    KIRAZ_PERF_CORPUS_DIR="${PERF_CORPUS_DIR}"
+    KIRAZ_PERF_BASELINE="${CMAKE_CURRENT_SOURCE_DIR}/kiraz/test/perf_baseline.txt"
+)
+add_dependencies(test_perf perf_corpora)
+
+if (KIRAZ_PERF_TESTS)
+    gtest_discover_tests(test_perf PROPERTIES LABELS perf RUN_SERIAL TRUE)
+endif()
+
 
 # test_wasmgen
 option(KIRAZ_TEST_WASMGEN "Enable wasmgen tests" TRUE)
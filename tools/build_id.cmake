@@ -0,0 +1,31 @@
+# Writes the id of the compiler build to OUTPUT, a hash of the sources below SOURCE_DIR that make
+# up the compiler. The file is only written when the id changes, so an unchanged tree rebuilds
+# nothing. The build runs it every time, see CMakeLists.txt:
+#   cmake -DSOURCE_DIR=<dir> -DOUTPUT=<header> -P build_id.cmake
+
+file(GLOB_RECURSE sources RELATIVE ${SOURCE_DIR}
+    ${SOURCE_DIR}/kiraz/*.h
+    ${SOURCE_DIR}/kiraz/*.cpp
+)
+list(FILTER sources EXCLUDE REGEX "^kiraz/(test|bench|fuzz)/")
+list(APPEND sources lexer.l parser.yy io.ki lexer.hpp main.h main.cpp)
+list(SORT sources)
+
+set(digests "")
+foreach(source IN LISTS sources)
+    file(SHA256 ${SOURCE_DIR}/${source} digest)
+    string(APPEND digests "${source} ${digest}\n")
+endforeach()
+string(SHA256 id "${digests}")
+string(SUBSTRING ${id} 0 16 id)
+
+string(CONCAT text "// Generated by tools/build_id.cmake, do not edit\n#pragma once\n\n"
+                   "#define KIRAZ_BUILD_ID \"${id}\"\n")
+
+set(current "")
+if (EXISTS ${OUTPUT})
+    file(READ ${OUTPUT} current)
+endif()
+if (NOT current STREQUAL text)
+    file(WRITE ${OUTPUT} "${text}")
+endif()
@@ -0,0 +1,396 @@
+/*
+ * kiraz_gen: Writes a synthetic Kiraz module for scale and stress testing. The output passes the
+ * checker and depends on nothing but the options, so a seed names the same workload on every
+ * platform. It is written as it is generated, which keeps the memory use flat however large the
+ * module gets.
+ *
+ * Code generation does not handle strings and imported calls yet, modules written with
+ * --strings or --io only make it through the front end.
+ *
+ * Usage: kiraz_gen [options] [output.ki]
+ */
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <string_view>
+
+namespace {
+
+struct Options {
+    uint64_t seed = 1;
+
+    /* Functions to write, ignored when a target size is given */
+    uint64_t num_funcs = 100;
+
+    /* Keeps writing functions until the output reaches this many bytes */
+    uint64_t target_size = 0;
+
+    uint64_t num_classes = 10;
+
+    /* Classes form inheritance chains of this many classes */
+    uint64_t inheritance_depth = 3;
+
+    /* Blocks nested inside each function body */
+    uint64_t nesting_depth = 2;
+
+    /* let statements at the top of each function */
+    uint64_t num_lets = 4;
+
+    /* String literals assigned in each function */
+    uint64_t num_strings = 0;
+
+    /* Operands in each expression */
+    uint64_t expr_size = 8;
+
+    /* Imports io and prints the strings */
+    bool io = false;
+};
+
+/* Buffers the output and hands it to stdio in large chunks */
+class Output {
+public:
+    static constexpr size_t CHUNK_SIZE = 1 << 20;
+
+    explicit Output(FILE *file) : m_file(file) { m_buffer.reserve(CHUNK_SIZE * 2); }
+
+    Output &operator<<(std::string_view text) {
+        m_buffer.append(text);
+        if (m_buffer.size() >= CHUNK_SIZE) {
+            flush();
+        }
+        return *this;
+    }
+
+    Output &operator<<(uint64_t value) { return *this << std::string_view(std::to_string(value)); }
+
+    bool flush() {
+        if (! m_buffer.empty()
+                && fwrite(m_buffer.data(), 1, m_buffer.size(), m_file) != m_buffer.size()) {
+            m_failed = true;
+        }
+        m_written += m_buffer.size();
+        m_buffer.clear();
+        return ! m_failed;
+    }
+
+    uint64_t size() const { return m_written + m_buffer.size(); }
+    bool is_failed() const { return m_failed; }
+
+private:
+    FILE *m_file;
+    std::string m_buffer;
+    uint64_t m_written = 0;
+    bool m_failed = false;
+};
+
+class Generator {
+public:
+    Generator(const Options &options, Output &out)
+            : m_options(options), m_out(out), m_rng(options.seed) {}
+
+    void run() {
+        if (m_options.io) {
+            m_out << "import io;\n\n";
+        }
+
+        for (uint64_t i = 0; i < m_options.num_classes; ++i) {
+            write_class(i);
+        }
+
+        uint64_t num_funcs = 0;
+        while (m_options.target_size ? m_out.size() < m_options.target_size
+                                     : num_funcs < m_options.num_funcs) {
+            if (m_out.is_failed()) {
+                return;
+            }
+            write_func(num_funcs++);
+        }
+
+        // main reaches every function through the call chain, so none of them is dead code
+        m_out << "func main() : Integer64 {\n";
+        if (num_funcs) {
+            m_out << "    return f" << (num_funcs - 1) << "(1, 2);\n";
+        }
+        else {
+            m_out << "    return 0;\n";
+        }
+        m_out << "};\n";
+    }
+
+private:
+    /* std distributions differ between standard libraries, this does not */
+    uint64_t roll(uint64_t bound) { return bound ? m_rng() % bound : 0; }
+
+    void indent(uint64_t level) {
+        for (uint64_t i = 0; i < level; ++i) {
+            m_out << "    ";
+        }
+    }
+
+    void write_class(uint64_t index) {
+        auto depth = m_options.inheritance_depth ? m_options.inheritance_depth : 1;
+        m_out << "class C" << index;
+        if (index % depth) {
+            m_out << " : C" << (index - 1);
+        }
+        m_out << " {\n";
+
+        // member names carry the class index, a derived class may not redefine them
+        m_out << "    let x" << index << " = " << roll(1000) << ";\n";
+        m_out << "    let y" << index << ": Integer64;\n";
+
+        // reads a member of the root of the chain, looked up through every parent
+        auto root = index - index % depth;
+        m_out << "    func get" << index << "() : Integer64 {\n";
+        m_out << "        return x" << root << " + x" << index << ";\n";
+        m_out << "    };\n";
+        m_out << "};\n\n";
+    }
+
+    void write_operand(uint64_t num_lets) {
+        switch (roll(4)) {
+        case 0:
+            m_out << "a";
+            break;
+        case 1:
+            m_out << "b";
+            break;
+        case 2:
+            if (num_lets) {
+                m_out << "v" << roll(num_lets);
+                break;
+            }
+            [[fallthrough]];
+        default:
+            m_out << roll(100);
+            break;
+        }
+    }
+
+    /* Written flat with the occasional parenthesized pair, so any size is fine for the stack */
+    void write_expr(uint64_t num_lets) {
+        static constexpr std::string_view OPS[] = {" + ", " - ", " * "};
+
+        auto size = m_options.expr_size ? m_options.expr_size : 1;
+        for (uint64_t i = 0; i < size; ++i) {
+            if (i) {
+                m_out << OPS[roll(3)];
+            }
+            if (i + 1 < size && roll(4) == 0) {
+                m_out << "(";
+                write_operand(num_lets);
+                m_out << OPS[roll(3)];
+                write_operand(num_lets);
+                m_out << ")";
+                ++i;
+            }
+            else {
+                write_operand(num_lets);
+            }
+        }
+    }
+
+    void write_block(uint64_t level, uint64_t depth) {
+        auto num_lets = m_options.num_lets;
+        if (depth % 2) {
+            indent(level);
+            m_out << "while (n < " << (roll(8) + 1) << ") {\n";
+            indent(level + 1);
+            m_out << "n = n + 1;\n";
+            indent(level + 1);
+            m_out << "s = s + ";
+            write_expr(num_lets);
+            m_out << ";\n";
+            if (depth > 1) {
+                write_block(level + 1, depth - 1);
+            }
+            indent(level);
+            m_out << "};\n";
+        }
+        else {
+            indent(level);
+            m_out << "if (s > " << roll(1000) << ") {\n";
+            indent(level + 1);
+            m_out << "s = s - ";
+            write_expr(num_lets);
+            m_out << ";\n";
+            if (depth > 1) {
+                write_block(level + 1, depth - 1);
+            }
+            indent(level);
+            m_out << "}\n";
+            indent(level);
+            m_out << "else {\n";
+            indent(level + 1);
+            m_out << "s = s + 1;\n";
+            indent(level);
+            m_out << "};\n";
+        }
+    }
+
+    void write_func(uint64_t index) {
+        m_out << "func f" << index << "(a: Integer64, b: Integer64) : Integer64 {\n";
+        for (uint64_t i = 0; i < m_options.num_lets; ++i) {
+            m_out << "    let v" << i << " = ";
+            write_expr(i);
+            m_out << ";\n";
+        }
+        m_out << "    let s = ";
+        write_expr(m_options.num_lets);
+        m_out << ";\n";
+        m_out << "    let n = 0;\n";
+
+        for (uint64_t i = 0; i < m_options.num_strings; ++i) {
+            m_out << "    let t" << i << " = \"f" << index << " string " << i << " "
+                  << m_rng() << "\";\n";
+            if (m_options.io) {
+                m_out << "    io.print(t" << i << ");\n";
+            }
+        }
+
+        if (m_options.nesting_depth) {
+            write_block(1, m_options.nesting_depth);
+        }
+
+        if (index) {
+            m_out << "    return f" << (index - 1) << "(s, n);\n";
+        }
+        else {
+            m_out << "    return s;\n";
+        }
+        m_out << "};\n\n";
+    }
+
+    const Options &m_options;
+    Output &m_out;
+    std::mt19937_64 m_rng;
+};
+
+void usage(const char *argv0) {
+    fprintf(stderr,
+            "Usage: %s [options] [output.ki]\n"
+            "Writes a synthetic Kiraz module to the given file, or to stdout.\n"
+            "\n"
+            "  --seed=N          random seed (1)\n"
+            "  --funcs=N         functions (100)\n"
+            "  --size=N[KMG]     write functions until the output reaches this size,\n"
+            "                    instead of a fixed number of them\n"
+            "  --classes=N       classes (10)\n"
+            "  --inherit=N       classes per inheritance chain (3)\n"
+            "  --nesting=N       nested while/if blocks per function (2)\n"
+            "  --lets=N          let statements per function (4)\n"
+            "  --strings=N       string literals per function (0)\n"
+            "  --expr=N          operands per expression (8)\n"
+            "  --io              import io and print the strings\n",
+            argv0);
+}
+
+/* Parses a count, with an optional K, M or G suffix */
+bool parse_count(const char *text, uint64_t &value) {
+    char *end = nullptr;
+    errno = 0;
+    value = strtoull(text, &end, 10);
+    if (errno || end == text) {
+        return false;
+    }
+    switch (*end) {
+    case 'K':
+        value <<= 10;
+        ++end;
+        break;
+    case 'M':
+        value <<= 20;
+        ++end;
+        break;
+    case 'G':
+        value <<= 30;
+        ++end;
+        break;
+    }
+    return *end == 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    Options options;
+    const char *output_name = nullptr;
+
+    struct CountOption {
+        std::string_view name;
+        uint64_t *value;
+    };
+    const CountOption count_options[] = {
+            {"--seed=", &options.seed},
+            {"--funcs=", &options.num_funcs},
+            {"--size=", &options.target_size},
+            {"--classes=", &options.num_classes},
+            {"--inherit=", &options.inheritance_depth},
+            {"--nesting=", &options.nesting_depth},
+            {"--lets=", &options.num_lets},
+            {"--strings=", &options.num_strings},
+            {"--expr=", &options.expr_size},
+    };
+
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            usage(argv[0]);
+            return 0;
+        }
+        if (arg == "--io") {
+            options.io = true;
+            continue;
+        }
+
+        bool found = false;
+        for (const auto &option : count_options) {
+            if (arg.starts_with(option.name)) {
+                if (! parse_count(argv[i] + option.name.size(), *option.value)) {
+                    fprintf(stderr, "Error: Invalid value in %s\n", argv[i]);
+                    return 1;
+                }
+                found = true;
+                break;
+            }
+        }
+        if (found) {
+            continue;
+        }
+
+        if (arg.starts_with("-") || output_name) {
+            usage(argv[0]);
+            return 1;
+        }
+        output_name = argv[i];
+    }
+
+    FILE *file = stdout;
+    if (output_name) {
+        file = fopen(output_name, "wb");
+        if (! file) {
+            fprintf(stderr, "Error: Unable to open %s: %s\n", output_name, strerror(errno));
+            return 1;
+        }
+    }
+
+    Output out(file);
+    Generator(options, out).run();
+    bool ok = out.flush();
+    if (file != stdout) {
+        ok = fclose(file) == 0 && ok;
+    }
+    else {
+        ok = fflush(file) == 0 && ok;
+    }
+    if (! ok) {
+        fprintf(stderr, "Error: Unable to write %s\n", output_name ? output_name : "the output");
+        return 1;
+    }
+    return 0;
+}
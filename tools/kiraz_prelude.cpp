@@ -0,0 +1,68 @@
+
+/*
+ * kiraz_prelude: Parses a prelude module and writes its serialized AST as a C++ header, so
+ * compilations can load the prelude without running the scanner and the parser.
+ *
+ * Usage: kiraz_prelude [input.ki] [output.h] [symbol name]
+ */
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+#include <fmt/format.h>
+
+#include <kiraz/Compiler.h>
+#include <kiraz/Prelude.h>
+#include <kiraz/ast/Statement.h>
+
+int main(int argc, char **argv) {
+    if (argc != 4) {
+        std::cerr << "Usage: " << argv[0] << " [input.ki] [output.h] [symbol name]" << std::endl;
+        return 1;
+    }
+
+    std::ifstream input(argv[1], std::ios::in | std::ios::binary);
+    if (! input.is_open()) {
+        std::cerr << "Error: Unable to open " << argv[1] << std::endl;
+        return 1;
+    }
+    std::string source((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+    Prelude::Bytes blob;
+    {
+        Compiler compiler;
+        auto module = compiler.compile_module(source);
+        if (! std::dynamic_pointer_cast<ast::Module>(module)) {
+            std::cerr << "Error: " << argv[1] << " is not a module" << std::endl;
+            return 1;
+        }
+        if (auto ret = Prelude::encode(module, blob)) {
+            std::cerr << FF("Error at {}:{}: {} can not be part of the prelude", ret->get_line(),
+                                 ret->get_col(), ret->as_string())
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    std::string name = argv[3];
+    std::string text = FF("// Generated by kiraz_prelude from {}, do not edit\n"
+                          "#pragma once\n\n"
+                          "#include <cstdint>\n\n"
+                          "inline constexpr uint8_t {}[] = {{",
+            std::filesystem::path(argv[1]).filename().string(), name);
+    for (size_t i = 0; i < blob.size(); ++i) {
+        text += FF("{}0x{:02x},", i % 16 ? " " : "\n    ", blob[i]);
+    }
+    text += "\n};\n";
+
+    std::ofstream output(argv[2], std::ios::out | std::ios::binary);
+    if (! output.write(text.data(), text.size())) {
+        std::cerr << "Error: Unable to write " << argv[2] << std::endl;
+        return 1;
+    }
+
+    return 0;
+}